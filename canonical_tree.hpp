@@ -0,0 +1,201 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _CANONICAL_TREE_HPP
+#define _CANONICAL_TREE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "config.h"
+
+namespace IVMPG {
+
+// Sequence of bits, written and read by fields of at most 64 bits
+class BitStream {
+
+  std::vector<uint64_t> words;
+  uint64_t nbits = 0;
+
+public:
+
+  uint64_t size() const { return nbits; }
+  size_t memory() const { return words.capacity() * sizeof(uint64_t); }
+  const std::vector<uint64_t> &data() const { return words; }
+
+  void write(uint64_t x, unsigned n) {
+    if (n == 0) return;
+    if (n < 64) x &= (uint64_t(1) << n) - 1;
+    const unsigned shift = nbits % 64;
+    if (shift == 0) words.push_back(x);
+    else {
+      words.back() |= x << shift;
+      if (shift + n > 64) words.push_back(x >> (64 - shift));
+    }
+    nbits += n;
+  }
+  // Drop the bits from n on
+  void truncate(uint64_t n) {
+    nbits = n;
+    words.resize((n + 63) / 64);
+    if (n % 64) words.back() &= (uint64_t(1) << (n % 64)) - 1;
+  }
+  void reset(uint64_t pos) { words[pos / 64] &= ~(uint64_t(1) << (pos % 64)); }
+  void append(const BitStream &other) {
+    for (uint64_t pos = 0; pos < other.nbits; pos += 64)
+      write(other.words[pos / 64], other.nbits - pos < 64 ? other.nbits - pos : 64);
+  }
+  // The n bits at pos, the bits past the end being zeros
+  uint64_t read(uint64_t pos, unsigned n) const {
+    if (n == 0 or pos >= nbits) return 0;
+    const unsigned shift = pos % 64;
+    uint64_t res = words[pos / 64] >> shift;
+    if (shift + n > 64 and pos / 64 + 1 < words.size()) res |= words[pos / 64 + 1] << (64 - shift);
+    if (pos + n > nbits) n = nbits - pos;
+    return n < 64 ? res & ((uint64_t(1) << n) - 1) : res;
+  }
+
+  void save(std::ostream &out) const {
+    out.write(reinterpret_cast<const char *>(&nbits), sizeof(nbits));
+    out.write(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(uint64_t));
+  }
+  void load(std::istream &in) {
+    in.read(reinterpret_cast<char *>(&nbits), sizeof(nbits));
+    words.resize((nbits + 63) / 64);
+    in.read(reinterpret_cast<char *>(words.data()), words.size() * sizeof(uint64_t));
+  }
+};
+
+
+// The enumeration tree of the canonical vectors of a given depth (see
+// PermutationGroup::DepthTree): the child i of a node adds one to its
+// coordinate i, i being at least the one of the node. The internal nodes are
+// stored in depth first order, each as the mask of its canonical children
+// from its own coordinate i to N-1, that is N-i bits. The leaves, at the
+// target depth, are only present in the mask of their parent. The nodes
+// without leaves in their subtree are left out. Consecutive
+// vectors sharing long prefixes, this is much smaller than the list of the
+// vectors, which are regenerated by the iterator one coordinate change at a
+// time.
+//
+// The tree of an interrupted enumeration misses the subtrees of some of the
+// nodes. The iterator reads them as having no children, so that it lists a
+// subset of the canonical vectors.
+template<class vect>
+class CanonicalTree {
+
+public:
+
+  uint64_t N = 0, depth = 0, max_part = 0;
+  uint64_t leaves = 0;    // number of vectors
+  bool truncated = false;
+  BitStream bits;
+
+  CanonicalTree() = default;
+  CanonicalTree(uint64_t N, uint64_t depth, uint64_t max_part) :
+    N(N), depth(depth), max_part(max_part) {}
+
+  uint64_t size() const { return leaves; }
+
+  class iterator : public std::iterator<std::input_iterator_tag, vect> {
+
+    // A node whose children are being listed
+    struct Frame {
+      uint64_t mask;     // children not yet visited
+      int64_t current;   // coordinate of the child being visited or -1
+    };
+
+    const CanonicalTree *tree;
+    std::vector<Frame> stack;
+    uint64_t pos;
+    vect v;
+
+    void push(uint64_t i) {
+      const uint64_t mask = tree->bits.read(pos, tree->N - i);
+      pos += tree->N - i;
+      stack.push_back({mask << i, -1});
+    }
+    // Move to the next leaf
+    void next() {
+      while (not stack.empty()) {
+	Frame &f = stack.back();
+	if (f.current >= 0) { v[f.current]--; f.current = -1; }
+	if (f.mask == 0) { stack.pop_back(); continue; }
+	const uint64_t i = __builtin_ctzll(f.mask);
+	f.mask &= f.mask - 1;
+	f.current = i;
+	v[i]++;
+	if (stack.size() == tree->depth) return;
+	push(i);
+      }
+    }
+
+  public:
+
+    iterator(const CanonicalTree *tree, bool end) : tree(tree), pos(0), v {} {
+      if (end) return;
+      if (tree->depth == 0) { stack.push_back({0, -1}); return; }
+      push(0);
+      next();
+    }
+    const vect &operator*() const { return v; }
+    const vect *operator->() const { return &v; }
+    iterator &operator++() {
+      if (tree->depth == 0) stack.clear();
+      else next();
+      return *this;
+    }
+    bool operator==(const iterator &other) const {
+      return stack.empty() == other.stack.empty() and (stack.empty() or pos == other.pos);
+    }
+    bool operator!=(const iterator &other) const { return not (*this == other); }
+  };
+  iterator begin() const { return iterator(this, false); }
+  iterator end() const { return iterator(this, true); }
+
+  void save(std::ostream &out) const {
+    const uint64_t head[6] = {N, depth, max_part, leaves, truncated, 0};
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<const char *>(head), sizeof(head));
+    bits.save(out);
+  }
+  void load(std::istream &in) {
+    char m[sizeof(magic)];
+    uint64_t head[6];
+    in.read(m, sizeof(m));
+    in.read(reinterpret_cast<char *>(head), sizeof(head));
+    if (not in or std::memcmp(m, magic, sizeof(magic)) != 0 or
+	head[0] == 0 or head[0] > vect::Size)
+      throw std::runtime_error("Not a canonical tree");
+    N = head[0]; depth = head[1]; max_part = head[2];
+    leaves = head[3]; truncated = head[4];
+    bits.load(in);
+    if (not in) throw std::runtime_error("Truncated canonical tree");
+  }
+
+  static const constexpr char magic[8] = {'I', 'V', 'M', 'P', 'G', 'T', 'R', '1'};
+};
+
+template<class vect>
+const constexpr char CanonicalTree<vect>::magic[8];
+
+} //  namespace IVMPG
+
+#endif // _CANONICAL_TREE_HPP
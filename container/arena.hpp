@@ -0,0 +1,192 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _ARENA_HPP
+#define _ARENA_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "config.h"
+#include "pages.hpp"
+
+#ifdef USE_CILK
+  #include <cilk/cilk_api.h>
+#endif
+
+namespace IVMPG {
+namespace Container {
+
+// Monotonic memory resource: memory is handed out by bumping a pointer in
+// large chunks, deallocation does nothing and all the chunks are returned
+// to the system together by release() or the destructor. Each Cilk worker
+// allocates in its own chunks so that no locking is needed.
+class MonotonicArena {
+
+  struct alignas(64) Region {
+    char *cur = nullptr, *end = nullptr;
+    std::vector< std::pair<void *, size_t> > chunks;
+  };
+  // The regions are on their own cache lines. Before C++17, new does not
+  // honour an alignment larger than the one of max_align_t.
+  struct FreeRegions {
+    size_t n;
+    void operator()(Region *p) const {
+      for (size_t i = 0; i < n; i++) p[i].~Region();
+      free(p);
+    }
+  };
+  static Region *make_regions(size_t n) {
+    void *mem = nullptr;
+    if (posix_memalign(&mem, alignof(Region), n * sizeof(Region))) throw std::bad_alloc();
+    Region *res = static_cast<Region *>(mem);
+    for (size_t i = 0; i < n; i++) new (&res[i]) Region;
+    return res;
+  }
+
+  size_t chunk_size;
+  size_t nregions;
+  std::unique_ptr<Region[], FreeRegions> regions;
+
+  static size_t worker() {
+#ifdef USE_CILK
+    return __cilkrts_get_worker_number();
+#else
+    return 0;
+#endif
+  }
+
+  void *allocate_slow(Region &reg, size_t size, size_t align);
+
+public:
+
+#ifdef USE_CILK
+  explicit MonotonicArena(size_t chunk_size = huge_page_size) :
+    chunk_size(chunk_size), nregions(__cilkrts_get_nworkers()),
+    regions(make_regions(nregions), FreeRegions {nregions}) { }
+#else
+  explicit MonotonicArena(size_t chunk_size = huge_page_size) :
+    chunk_size(chunk_size), nregions(1), regions(make_regions(1), FreeRegions {1}) { }
+#endif
+  MonotonicArena(const MonotonicArena &) = delete;
+  MonotonicArena &operator=(const MonotonicArena &) = delete;
+  ~MonotonicArena() { release(); }
+
+  void *allocate(size_t size, size_t align) {
+    assert(worker() < nregions);
+    Region &reg = regions[worker()];
+    const uintptr_t p = (uintptr_t(reg.cur) + align - 1) & ~uintptr_t(align - 1);
+    if (p + size > uintptr_t(reg.end)) return allocate_slow(reg, size, align);
+    reg.cur = reinterpret_cast<char *>(p + size);
+    return reinterpret_cast<void *>(p);
+  }
+
+  // Size of the chunks currently mapped
+  size_t reserved() const;
+  // Give back all the memory. Nothing allocated by the arena must be used
+  // after this.
+  void release();
+
+};
+
+// Chunks are mapped directly so that their memory really goes back to the
+// system on release, whatever the thresholds of malloc. By default they are
+// huge pages (see map_pages).
+inline void *MonotonicArena::allocate_slow(Region &reg, size_t size, size_t align) {
+  size_t len = chunk_size;
+  while (len < size + align) len *= 2;
+  void *chunk = map_pages(len);
+  reg.chunks.emplace_back(chunk, len);
+  reg.cur = static_cast<char *>(chunk);
+  reg.end = reg.cur + len;
+  return allocate(size, align);
+}
+
+inline size_t MonotonicArena::reserved() const {
+  size_t res = 0;
+  for (size_t i = 0; i < nregions; i++)
+    for (const auto &chunk : regions[i].chunks) res += chunk.second;
+  return res;
+}
+
+inline void MonotonicArena::release() {
+  for (size_t i = 0; i < nregions; i++) {
+    Region &reg = regions[i];
+    for (const auto &chunk : reg.chunks) unmap_pages(chunk.first, chunk.second);
+    reg.chunks.clear();
+    reg.cur = reg.end = nullptr;
+  }
+}
+
+
+// Arena used by the default constructed ArenaAllocator, set by ArenaScope.
+// Under Cilk, the reducers build the lists of the other strands with default
+// constructed allocators, so that a scope is needed there.
+template <class Dummy = void>
+struct DefaultArenaHolder { static MonotonicArena *arena; };
+template <class Dummy>
+MonotonicArena *DefaultArenaHolder<Dummy>::arena = nullptr;
+
+class ArenaScope {
+  MonotonicArena *previous;
+public:
+  explicit ArenaScope(MonotonicArena &arena) : previous(DefaultArenaHolder<>::arena) {
+    DefaultArenaHolder<>::arena = &arena;
+  }
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+  ~ArenaScope() { DefaultArenaHolder<>::arena = previous; }
+};
+
+// Standard allocator interface to a MonotonicArena. All the allocators of the
+// same arena compare equal so that lists can be spliced between threads.
+template <class T>
+struct ArenaAllocator {
+
+  using value_type = T;
+  template <class U> struct rebind { using other = ArenaAllocator<U>; };
+
+  MonotonicArena *arena;
+
+  ArenaAllocator() : arena(DefaultArenaHolder<>::arena) { assert(arena != nullptr); }
+  explicit ArenaAllocator(MonotonicArena &arena) : arena(&arena) { }
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) { }
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) { }
+
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena == b.arena;
+}
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena != b.arena;
+}
+
+} //  namespace Container
+} //  namespace IVMPG
+
+#endif // _ARENA_HPP
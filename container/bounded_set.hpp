@@ -16,16 +16,11 @@
 #ifndef _BOUNDED_SET_HPP
 #define _BOUNDED_SET_HPP
 
-// #define SET_STATISTIC
-
-#ifdef SET_STATISTIC
-#include <iostream>
-#include <iomanip>
-#include <iostream>
-#endif
-
 #include <memory>
 #include <cassert>
+#include <ostream>
+
+#include "statistics.hpp"
 
 namespace IVMPG {
 namespace Container {
@@ -45,9 +40,9 @@ class bounded_set {
   // percents speed using direct access.
   Pair *buckets;
   Pair *first;
-  #ifdef SET_STATISTIC
-  size_t collide = 0, success = 0, request = 0;
-  #endif
+  // Number of keys, and whether a key was refused (see insert)
+  size_t count;
+  bool overflow;
   class Iterator;
 
   Pair * sentinel() const { return &(buckets[bound]); }
@@ -59,17 +54,23 @@ public:
   typedef Iterator iterator;
 
   // We use an extra uninitialized pair as a sentinel for the end of the linked list.
+  // The buckets are first touched by the thread building the set, which is
+  // the worker using it (see Storage_thread_local).
   bounded_set() :
     buckets_own(new Pair[bound+1]), buckets(buckets_own.get()),
-    first(&(buckets[bound])) {
+    first(&(buckets[bound])), count(0), overflow(false) {
     for (size_t i=0; i<bound; ++i) buckets[i].next = nullptr;
   }
 
+  // The set holds at most bound-1 keys, so that the probes always reach an
+  // empty bucket. The new keys are refused once it is full, overflowed() being
+  // then true until the next clear.
   void insert(Key key);
   void clear();
   Iterator begin() const { return {*this, first}; }
   Iterator end() const { return {*this, sentinel()}; }
-  size_t size() const;
+  size_t size() const { return count; }
+  bool overflowed() const { return overflow; }
 
 private:
 
@@ -98,11 +99,6 @@ const constexpr Hash bounded_set<Key, Hash, bound>::hashfun;
 //   assert(this != &rhs);
 //   buckets = std::move(rhs.buckets);
 //   first   = rhs.first;
-// #ifdef SET_STATISTIC
-//   collide = rhs.collide;
-//   success = rhs.success;
-//   request = rhs.request;
-// #endif
 //   rhs.buckets = nullptr; // to avoid double free
 //   return *this;
 // }
@@ -114,37 +110,34 @@ void bounded_set<Key, Hash, bound>::clear() {
     first = first->next;
     tmp->next = nullptr;
   }
+  count = 0;
+  overflow = false;
 }
 
 template <class Key, class Hash, size_t bound>
 void bounded_set<Key, Hash, bound>::insert(Key key) {
-#ifdef SET_STATISTIC
-  request++;
-#endif
+  // The hash functions are expected to mix their low bits
+  static_assert((bound & (bound-1)) == 0, "bound must be a power of 2");
   size_t hash = hashfun(key) & (bound-1);
+  uint64_t probe = 0;
   while (buckets[hash].next != nullptr and buckets[hash].key != key) {
     hash = hash < bound-1 ? hash+1 : 0;
-#ifdef SET_STATISTIC
-    collide++;
-#endif
+    probe++;
   }
-  if (buckets[hash].next == nullptr) {
-#ifdef SET_STATISTIC
-    success++;
-#endif
+  const bool new_key = buckets[hash].next == nullptr;
+  if (new_key and count == bound-1) overflow = true;
+  else if (new_key) {
     buckets[hash].key = key;
     buckets[hash].next = first;
     first = &(buckets[hash]);
+    count++;
   }
+  if (statistics().is_enabled()) statistics().local().record_insert(probe, new_key);
 }
 
+// Same as set.overflowed(), the other sets never refusing a key (see group.hpp)
 template <class Key, class Hash, size_t bound>
-size_t bounded_set<Key, Hash, bound>::size() const {
-  Pair *it = first;
-  std::size_t count = 0;
-  while (it != sentinel()) {count++; it = it->next;}
-  return count;
-}
+bool overflowed(const bounded_set<Key, Hash, bound> &set) { return set.overflowed(); }
 
 template <class Key, class Hash, size_t bound>
 std::ostream & operator<<(std::ostream & stream, bounded_set<Key, Hash, bound> const &set) {
@@ -0,0 +1,48 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _PAGES_HPP
+#define _PAGES_HPP
+
+#include <cstddef>
+#include <new>
+#include <sys/mman.h>
+
+namespace IVMPG {
+namespace Container {
+
+const size_t huge_page_size = 2 << 20;
+
+// Anonymous zero filled memory mapping, for the large and long lived blocks
+// such as the arena chunks. Its pages are physically allocated on the NUMA
+// node of the thread which first touches them, whereas malloc may return
+// memory already touched by another thread. The mappings of at least a huge
+// page are advised to use transparent huge pages when available.
+inline void *map_pages(size_t bytes) {
+  void *res = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (res == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+  if (bytes >= huge_page_size) madvise(res, bytes, MADV_HUGEPAGE);
+#endif
+  return res;
+}
+
+inline void unmap_pages(void *p, size_t bytes) { munmap(p, bytes); }
+
+} //  namespace Container
+} //  namespace IVMPG
+
+#endif // _PAGES_HPP
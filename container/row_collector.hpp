@@ -0,0 +1,99 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _ROW_COLLECTOR_HPP
+#define _ROW_COLLECTOR_HPP
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "config.h"
+#include "temp_storage.hpp"
+
+namespace IVMPG {
+namespace Container {
+
+// Collects rows of width entries in contiguous chunks. When a sink is given,
+// each full chunk is handed to it, otherwise all the rows are gathered in
+// buffer(). Under Cilk each worker fills its own chunk, so that the order of
+// the rows is only the order of insertion in serial.
+template <class Entry>
+class RowCollector {
+
+public:
+
+  using chunk = std::vector<Entry>;
+  // Called under a lock. May swap rows with an empty vector to keep them.
+  using sink_type = void (*)(void *context, chunk &rows);
+
+private:
+
+#ifdef USE_CILK
+  using Chunks = Storage_thread_local<chunk>;
+#else
+  using Chunks = Storage_dummy<chunk>;
+#endif
+
+  const size_t width, chunk_size;
+  const sink_type sink;
+  void *const context;
+  Chunks chunks;
+  std::mutex mutex;
+  chunk rows;
+  uint64_t nrows = 0;
+
+  void flush(chunk &c) {
+    std::lock_guard<std::mutex> lock(mutex);
+    nrows += c.size() / width;
+    if (sink) sink(context, c);
+    else if (rows.empty()) rows.swap(c);
+    else rows.insert(rows.end(), c.begin(), c.end());
+    c.clear();
+  }
+
+public:
+
+  explicit RowCollector(size_t width,
+			size_t chunk_rows = std::numeric_limits<size_t>::max(),
+			sink_type sink = nullptr, void *context = nullptr) :
+    width(width),
+    chunk_size(chunk_rows > std::numeric_limits<size_t>::max() / width ?
+	       std::numeric_limits<size_t>::max() : chunk_rows * width),
+    sink(sink), context(context) {}
+  RowCollector(const RowCollector &) = delete;
+
+  template <class Vect>
+  void push(const Vect &v) {
+    chunk &c = chunks.get_store();
+    for (size_t i = 0; i < width; i++) c.push_back(v[i]);
+    if (c.size() >= chunk_size) flush(c);
+  }
+
+  // Flush the partial chunks and return the total number of rows. Not
+  // thread safe, to be called once the rows are all pushed.
+  uint64_t finish() {
+    chunks.for_each([this](chunk &c) { if (not c.empty()) flush(c); });
+    return nrows;
+  }
+  // The rows when there is no sink
+  chunk &buffer() { return rows; }
+};
+
+} //  namespace Container
+} //  namespace IVMPG
+
+#endif // _ROW_COLLECTOR_HPP
@@ -0,0 +1,137 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#include <cpuid.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+
+#include "cpu_dispatch.hpp"
+#include "group_kernels.hpp"
+
+#ifndef bit_AVX2
+#define bit_AVX2        (1 << 5)
+#endif
+#ifndef bit_BMI2
+#define bit_BMI2        (1 << 8)
+#endif
+#ifndef bit_AVX512F
+#define bit_AVX512F     (1 << 16)
+#endif
+#ifndef bit_AVX512BW
+#define bit_AVX512BW    (1 << 30)
+#endif
+#ifndef bit_AVX512VL
+#define bit_AVX512VL    (1u << 31)
+#endif
+#ifndef bit_AVX512VBMI
+#define bit_AVX512VBMI  (1 << 1)
+#endif
+
+namespace IVMPG {
+
+static uint64_t xgetbv0() {
+  uint32_t eax, edx;
+  __asm__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (uint64_t(edx) << 32) | eax;
+}
+
+static ISA processor_isa() {
+  unsigned int ax, bx, cx, dx;
+  if (not __get_cpuid(1, &ax, &bx, &cx, &dx)) return ISA::SSE4_2;
+  if (not ((cx & bit_OSXSAVE) and (cx & bit_AVX))) return ISA::SSE4_2;
+  // The OS must save the YMM (resp. ZMM and opmask) registers
+  const uint64_t xcr0 = xgetbv0();
+  if ((xcr0 & 0x06) != 0x06 or __get_cpuid_max(0, nullptr) < 7) return ISA::SSE4_2;
+  __cpuid_count(7, 0, ax, bx, cx, dx);
+  if (not ((bx & bit_AVX2) and (bx & bit_BMI2))) return ISA::SSE4_2;
+  if ((xcr0 & 0xe6) == 0xe6 and (bx & bit_AVX512F) and (bx & bit_AVX512BW) and
+      (bx & bit_AVX512VL) and (cx & bit_AVX512VBMI))
+    return ISA::AVX512;
+  return ISA::AVX2;
+}
+
+ISA cpu_isa() {
+  static const ISA isa = processor_isa();
+#if defined(HAVE_AVX512_KERNELS)
+  return isa;
+#elif defined(HAVE_AVX2_KERNELS)
+  return isa == ISA::SSE4_2 ? ISA::SSE4_2 : ISA::AVX2;
+#else
+  return ISA::SSE4_2;
+#endif
+}
+
+const char *isa_name(ISA isa) {
+  switch (isa) {
+  case ISA::AVX512: return "avx512";
+  case ISA::AVX2: return "avx2";
+  default: return "sse4.2";
+  }
+}
+
+static std::atomic<int> current_isa {-1};
+
+ISA dispatch_isa() {
+  if (current_isa.load(std::memory_order_relaxed) < 0) {
+    ISA isa = cpu_isa();
+    if (const char *env = std::getenv("IVMPG_ISA"))
+      for (ISA lvl : {ISA::SSE4_2, ISA::AVX2, ISA::AVX512})
+	if (std::strcmp(env, isa_name(lvl)) == 0 and lvl < isa) isa = lvl;
+    set_dispatch_isa(isa);
+  }
+  return ISA(current_isa.load(std::memory_order_relaxed));
+}
+
+template<class perm>
+static typename CanonicalKernel<perm>::type canonical_kernel(ISA isa) {
+  using kernel = typename CanonicalKernel<perm>::type;
+  switch (isa) {
+#ifdef HAVE_AVX512_KERNELS
+  case ISA::AVX512: return kernel(Kernels::avx512::is_canonical);
+#endif
+#ifdef HAVE_AVX2_KERNELS
+  case ISA::AVX2: return kernel(Kernels::avx2::is_canonical);
+#endif
+  default: return kernel(Kernels::sse4_2::is_canonical);
+  }
+}
+
+void set_dispatch_isa(ISA isa) {
+  if (isa > cpu_isa()) isa = cpu_isa();
+  CanonicalKernel<Perm16>::fun.store(canonical_kernel<Perm16>(isa), std::memory_order_relaxed);
+  CanonicalKernel<Perm32>::fun.store(canonical_kernel<Perm32>(isa), std::memory_order_relaxed);
+  CanonicalKernel<Perm64>::fun.store(canonical_kernel<Perm64>(isa), std::memory_order_relaxed);
+  current_isa.store(int(isa), std::memory_order_relaxed);
+}
+
+// The kernels initially point to a resolver which selects them on first
+// call. This is safe whatever the order of the static initializations.
+template<class perm>
+static bool resolve_canonical(const PermutationGroup<perm> &g, typename perm::vect v,
+			      typename PermutationGroup<perm>::TemporaryStorage &st) {
+  dispatch_isa();
+  return CanonicalKernel<perm>::fun.load(std::memory_order_relaxed)(g, v, st);
+}
+
+template<> std::atomic<CanonicalKernel<Perm16>::type>
+CanonicalKernel<Perm16>::fun {resolve_canonical<Perm16>};
+template<> std::atomic<CanonicalKernel<Perm32>::type>
+CanonicalKernel<Perm32>::fun {resolve_canonical<Perm32>};
+template<> std::atomic<CanonicalKernel<Perm64>::type>
+CanonicalKernel<Perm64>::fun {resolve_canonical<Perm64>};
+
+} // namespace IVMPG
@@ -0,0 +1,39 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _CPU_DISPATCH_HPP
+#define _CPU_DISPATCH_HPP
+
+#include "config.h"
+
+namespace IVMPG {
+
+// Instruction set levels for which the hot kernels are compiled. The build
+// only assumes SSE4.2; the better levels are used if the processor allows it.
+enum class ISA : int { SSE4_2 = 0, AVX2 = 1, AVX512 = 2 };
+
+// Best level supported by the processor and compiled in the program
+ISA cpu_isa();
+// Level currently used by the kernels. It defaults to cpu_isa() and can be
+// lowered with the environment variable IVMPG_ISA=sse4.2|avx2|avx512.
+ISA dispatch_isa();
+// Select the kernels; the level is capped by cpu_isa().
+void set_dispatch_isa(ISA isa);
+
+const char *isa_name(ISA isa);
+
+} // namespace IVMPG
+
+#endif
@@ -0,0 +1,184 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _ENUMERATION_CACHE_HPP
+#define _ENUMERATION_CACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "group16.hpp"
+#include "packed_file.hpp"
+
+namespace IVMPG {
+
+// Persistent cache of the enumerations in a directory, shared by the jobs.
+// The results of a query are stored under the fingerprint of the group and
+// the parameters of the query:
+//
+//   <fingerprint>-d<depth>-m<max_part>.count   number of vectors, as text
+//   <fingerprint>-d<depth>-m<max_part>.ivp     packed listing
+//   <fingerprint>-e<e0>,<e1>,...               same for an evaluation
+//
+// Only the complete results are stored. The files are written under a
+// temporary name then renamed, so that concurrent jobs never see a partial
+// file; at worst they compute the same result twice.
+class EnumerationCache {
+
+  using Group = PermutationGroup16;
+
+  std::string dir;
+  uint64_t temporaries = 0;
+
+  std::string temporary(const std::string &filename) {
+    return filename + ".tmp" + std::to_string(getpid()) + "-" + std::to_string(temporaries++);
+  }
+  void commit(const std::string &tmp, const std::string &filename) {
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+      std::remove(tmp.c_str());
+      throw std::runtime_error("Unable to write " + filename);
+    }
+  }
+
+  static bool exists(const std::string &filename) {
+    struct stat st;
+    return stat(filename.c_str(), &st) == 0;
+  }
+
+  bool read_count(const std::string &path, uint64_t &res) const {
+    if (exists(path + ".ivp")) {
+      res = PackedReader(path + ".ivp").size();
+      return true;
+    }
+    std::ifstream in(path + ".count");
+    return bool(in >> res);
+  }
+  void write_count(const std::string &path, uint64_t res) {
+    const std::string tmp = temporary(path + ".count");
+    std::ofstream out(tmp);
+    out << res << "\n";
+    out.close();
+    if (not out) {
+      std::remove(tmp.c_str());
+      throw std::runtime_error("Unable to write " + tmp);
+    }
+    commit(tmp, path + ".count");
+  }
+
+  template <class Walk>
+  uint64_t count(const std::string &path, EnumerationControl *ctl, Walk walk) {
+    uint64_t res;
+    if (read_count(path, res)) return res;
+    res = walk();
+    if (not (ctl and ctl->truncated())) write_count(path, res);
+    return res;
+  }
+
+  static void packed_sink(void *context, Group::RowCollector::chunk &rows) {
+    PackedWriter &out = *static_cast<PackedWriter *>(context);
+    out.push(rows.data(), rows.size() / out.header().N);
+  }
+  // The listing is written to a temporary file, renamed if complete or else
+  // unlinked once mapped.
+  template <class Walk>
+  PackedReader listing(const Group &g, const std::string &path, EnumerationControl *ctl,
+		       Walk walk) {
+    const std::string filename = path + ".ivp";
+    if (exists(filename)) return PackedReader(filename);
+    const std::string tmp = temporary(filename);
+    try {
+      PackedWriter out(tmp, g.fingerprint(), g.N);
+      Group::RowCollector rows(g.N, 4096, packed_sink, &out);
+      walk(out, rows);
+      out.close();
+    } catch (...) {
+      std::remove(tmp.c_str());
+      throw;
+    }
+    if (ctl and ctl->truncated()) {
+      PackedReader res(tmp);
+      std::remove(tmp.c_str());
+      return res;
+    }
+    commit(tmp, filename);
+    return PackedReader(filename);
+  }
+
+public:
+
+  // The directory is created if needed.
+  explicit EnumerationCache(const std::string &directory) : dir(directory) {
+    if (mkdir(dir.c_str(), 0777) != 0 and not exists(dir))
+      throw std::runtime_error("Unable to create " + dir);
+  }
+
+  const std::string &directory() const { return dir; }
+  // Path of the files of a query, without their extension. The coordinates
+  // of the vectors of sum depth are at most depth, so that all the max_part
+  // from depth on share the same files.
+  std::string path(const Group &g, uint64_t depth, uint64_t max_part) const {
+    std::ostringstream res;
+    res << dir << "/" << std::hex << g.fingerprint() << std::dec
+	<< "-d" << depth << "-m" << std::min(max_part, depth);
+    return res.str();
+  }
+  std::string path(const Group &g, const Vect16 &eval) const {
+    std::ostringstream res;
+    res << dir << "/" << std::hex << g.fingerprint() << std::dec << "-e";
+    for (uint64_t i = 0; i < g.N; i++) res << (i ? "," : "") << unsigned(eval[i]);
+    return res.str();
+  }
+
+  // Same as the methods of PermutationGroup16, the results of a truncated
+  // enumeration (see EnumerationControl) being returned but not stored.
+  uint64_t elements_of_depth_number(const Group &g, uint64_t depth, uint64_t max_part,
+				    EnumerationControl *ctl = nullptr) {
+    return count(path(g, depth, max_part), ctl, [&]() {
+	return g.elements_of_depth_number(depth, max_part, ctl); });
+  }
+  uint64_t elements_of_evaluation_number(const Group &g, const Vect16 &eval,
+					 EnumerationControl *ctl = nullptr) {
+    return count(path(g, eval), ctl, [&]() {
+	return g.elements_of_evaluation_number(eval, ctl); });
+  }
+  PackedReader elements_of_depth(const Group &g, uint64_t depth, uint64_t max_part,
+				 EnumerationControl *ctl = nullptr) {
+    return listing(g, path(g, depth, max_part), ctl,
+		   [&](PackedWriter &out, Group::RowCollector &rows) {
+		     out.set_depth(depth, max_part);
+		     g.elements_of_depth_rows(depth, max_part, rows, ctl);
+		   });
+  }
+  PackedReader elements_of_evaluation(const Group &g, const Vect16 &eval,
+				      EnumerationControl *ctl = nullptr) {
+    return listing(g, path(g, eval), ctl,
+		   [&](PackedWriter &out, Group::RowCollector &rows) {
+		     out.set_evaluation(eval);
+		     g.elements_of_evaluation_rows(eval, rows, ctl);
+		   });
+  }
+};
+
+} //  namespace IVMPG
+
+#endif // _ENUMERATION_CACHE_HPP
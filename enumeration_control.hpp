@@ -0,0 +1,78 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _ENUMERATION_CONTROL_HPP
+#define _ENUMERATION_CONTROL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace IVMPG {
+
+// Stops an enumeration when cancelled from another thread, when it found
+// max_results results or when the deadline is passed. The enumeration then
+// returns the results found so far and truncated() tells that some are
+// missing. A control object is meant for a single enumeration.
+class EnumerationControl {
+
+  std::atomic<bool> stop_flag {false};
+  std::atomic<uint64_t> nresults {0};
+
+public:
+
+  using clock = std::chrono::steady_clock;
+
+  uint64_t max_results = std::numeric_limits<uint64_t>::max();
+  clock::time_point deadline = clock::time_point::max();
+
+  // The walkers check the deadline once every poll_period nodes
+  static const constexpr uint64_t poll_period = 1024;
+
+  EnumerationControl() = default;
+  EnumerationControl(uint64_t max_results) : max_results(max_results) {}
+  EnumerationControl(clock::duration timeout) :
+    deadline(clock::now() + timeout) {}
+
+  void set_timeout(clock::duration timeout) { deadline = clock::now() + timeout; }
+  void set_timeout_seconds(double seconds) {
+    set_timeout(std::chrono::duration_cast<clock::duration>(
+		  std::chrono::duration<double>(seconds)));
+  }
+  // Thread safe, the workers stop at their next node
+  void cancel() { stop_flag.store(true, std::memory_order_relaxed); }
+
+  bool stopped() const { return stop_flag.load(std::memory_order_relaxed); }
+  bool truncated() const { return stopped(); }
+  // Number of results given to the enumeration
+  uint64_t results() const { return nresults.load(std::memory_order_relaxed); }
+
+  bool poll() {
+    if (deadline != clock::time_point::max() and clock::now() >= deadline) cancel();
+    return stopped();
+  }
+  // Whether one more result may be given, counting it
+  bool take_result() {
+    if (nresults.fetch_add(1, std::memory_order_relaxed) < max_results) return true;
+    nresults.fetch_sub(1, std::memory_order_relaxed);
+    cancel();
+    return false;
+  }
+};
+
+} // namespace IVMPG
+
+#endif // _ENUMERATION_CONTROL_HPP
@@ -18,9 +18,15 @@
 
 #include <cassert>
 #include <utility>
+#include <type_traits>
 #include <vector>
+#include <memory>
 #include <list>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
 #include "config.h"
 #include <ostream>
 
@@ -32,6 +38,8 @@
   #include <cilk/reducer_opadd.h>
 #else
   #define cilk_spawn
+  #define cilk_sync
+  #define cilk_for for
 #endif
 
 
@@ -76,9 +84,25 @@ namespace IVMPG {
 }
 #endif
 
+namespace IVMPG {
+  // Whether the set refused a key, only the bounded sets having a capacity
+  // (see container/bounded_set.hpp).
+  template<class Set>
+  inline bool overflowed(const Set &) { return false; }
+}
+
 
 #include "temp_storage.hpp"
+#include "statistics.hpp"
+#include "tracer.hpp"
+#include "container/arena.hpp"
+#include "container/row_collector.hpp"
+#include "canonical_tree.hpp"
+#include "enumeration_control.hpp"
 #include "perm16.hpp"
+#include "perm16w.hpp"
+#include "perm_simd.hpp"
+#include "cpu_dispatch.hpp"
 
 namespace IVMPG {
 
@@ -90,43 +114,239 @@ public:
   using vect = typename perm::vect;
   using list = std::list<vect, allocator<vect> >;
   using StrongGeneratingSet = std::vector< std::vector< perm > >;
-  using TemporaryStorage = std::pair< set<vect>, set<vect> >;
+  // Images of a block of the frontier in expand_frontiers, and the largest
+  // one stopping the expansion if any, with the index of its element in the
+  // transversal.
+  struct FrontierBlock {
+    std::vector<vect> images;
+    vect stop;
+    uint64_t stop_index;
+    bool stopped;
+  };
+  struct TemporaryStorage : std::pair< set<vect>, set<vect> > {
+    // Images counted with their multiplicity (see stabilizer_order)
+    std::vector< std::pair<vect, uint64_t> > counted, new_counted;
+    // Frontiers overflowing the sets (see expand_frontiers)
+    std::vector<vect> frontier;
+    std::vector<FrontierBlock> blocks;
+  };
+  // Type of the coordinates
+  using entry = typename std::decay<decltype(std::declval<const vect &>()[0])>::type;
 
   std::string name;
   uint64_t N;
   StrongGeneratingSet sgs;
+  // The stabilizer of the points 0..sym_tail-1 is the full symmetric group
+  // on the remaining points, so that canonicity on the coordinates sym_tail..N-1
+  // reduces to being non increasing there.
+  uint64_t sym_tail;
 
 private:
 
 #ifdef USE_CILK
 #define CILK_GET_VALUE(v) (v).get_value()
   using counter = cilk::reducer_opadd< uint64_t >;
-  using list_generator = cilk::reducer_list_append< vect, allocator<vect> >;
+  template<class Alloc>
+  using list_generator = cilk::reducer_list_append< vect, Alloc >;
+  using stabilizer_generator = cilk::reducer_list_append< std::pair<vect, uint64_t> >;
 
   // Using thread local only gain a few percent
   // using BFS_storage = Storage_holder< TemporaryStorage >;
   using BFS_storage = Storage_thread_local< TemporaryStorage >;
+  // Number of levels of the enumeration trees spawned as Cilk tasks
+  static const constexpr uint64_t spawn_levels = 8;
+  // Size of the frontiers of a single canonical test shared among the Cilk
+  // workers, the capacity of the default bounded sets (see expand_frontiers)
+  static const constexpr size_t parallel_frontier = 1024;
 #else
-#define CILK_GET_VALUE(v) (v)
+#define CILK_GET_VALUE(v) std::move(v)
   using counter = uint64_t;
-  using list_generator = std::list< vect, allocator<vect> >;
+  template<class Alloc>
+  using list_generator = std::list< vect, Alloc >;
+  using stabilizer_generator = std::list< std::pair<vect, uint64_t> >;
   using BFS_storage = Storage_dummy< TemporaryStorage >;
+  static const constexpr uint64_t spawn_levels = 0;
+  static const constexpr size_t parallel_frontier = ~size_t(0);
 #endif
 
+  // Call f(i, row i, storage) on the rows of canonical_rows
+  template <class F>
+  void for_each_row(const entry *in, size_t n, size_t stride, F f) const;
+  // Generic canonical test, calling reject(i, k) when v is rejected by the
+  // element k of the transversal sgs[i].
+  template<class Reject>
+  bool is_canonical_generic(vect v, TemporaryStorage &, Reject reject) const;
+  // The frontiers of v by the levels of sgs before sym_tail, as in
+  // is_canonical, the frontiers larger than threshold being expanded by blocks
+  // shared among the Cilk workers. test(i, child) returns -1 to stop the
+  // expansion, 1 to keep child in the next frontier and 0 otherwise. Return the
+  // level of the stop, stop being then the largest stopping child found and
+  // stop_index the index of its element in the transversal, or sym_tail if
+  // there was none.
+  template<class Test>
+  uint64_t expand_frontiers(const vect &v, TemporaryStorage &, size_t threshold,
+			    Test test, vect &stop, uint64_t &stop_index) const;
+  // Same as is_canonical_parallel, calling reject as is_canonical_generic
+  template<class Reject>
+  bool is_canonical_parallel(vect v, TemporaryStorage &, size_t threshold,
+			     Reject reject) const;
+  // Result of the canonical test, rejected at the given level of sgs
+  static bool canonical_result(bool res, uint64_t level) {
+    if (statistics().is_enabled()) statistics().local().record_canonical(res, level);
+    return res;
+  }
+
 public:
 
   PermutationGroup(std::string name, uint64_t N, StrongGeneratingSet sgs) :
-    name(name), N(N), sgs(sgs) { assert(check_sgs()); };
+    name(name), N(N), sgs(sgs), sym_tail(symmetric_tail()) { assert(check_sgs()); };
+  // The group generated by gens, its strong generating set for the base
+  // 0, 1, ..., N-1 being computed by the Schreier-Sims algorithm.
+  static PermutationGroup from_generators(std::string name, uint64_t N,
+					  const std::vector<perm> &gens);
   bool check_sgs() const;
+  // Hash of the group for the base 0, 1, ..., N-1, independent of its strong
+  // generating set.
+  uint64_t fingerprint() const;
+  uint64_t symmetric_tail() const;
   bool is_canonical(vect v) const;
   bool is_canonical(vect v, TemporaryStorage &) const;
+  // Same as is_canonical, bypassing the runtime CPU dispatch
+  bool is_canonical_kernel(vect v, TemporaryStorage &) const;
+  // Operations of the vectors in is_canonical_mask. The kernels compiled for
+  // AVX2 and AVX512 replace them by their own (see group_kernels.cpp).
+  struct VectOps {
+    static vect permuted(const vect &v, const perm &p) { return v.permuted(p); }
+    static uint64_t diff_mask(const vect &a, const vect &b) { return a.diff_mask(b); }
+    static uint64_t lt_mask(const vect &a, const vect &b) { return a.lt_mask(b); }
+  };
+  // Canonical test for the vector types providing diff_mask and lt_mask
+  template<class Ops = VectOps>
+  bool is_canonical_mask(vect v, TemporaryStorage &) const;
   vect canonical(vect v) const;
+  // Same as is_canonical and canonical, the expansion of the frontiers larger
+  // than threshold being shared among the Cilk workers, which stop together on
+  // the first larger image. The frontiers are not limited by the capacity of
+  // the sets, and the other canonical tests switch to these ones when one of
+  // their frontiers overflows.
+  bool is_canonical_parallel(vect v, TemporaryStorage &,
+			     size_t threshold = parallel_frontier) const;
+  vect canonical_parallel(vect v, TemporaryStorage &,
+			  size_t threshold = parallel_frontier) const;
+  // The canonical test stops at the first image of v larger than v. Reorder
+  // the transversals of sgs, the identity staying first, so that the elements
+  // rejecting the most children of the canonical vectors of sum less than
+  // depth come first. This only changes the speed of the canonical tests, but
+  // the group must not be in use meanwhile.
+  void sort_transversals(uint64_t depth, uint64_t max_part);
+  // Order of the group and of the stabilizer of v, exact as long as the order
+  // of the group fits in 64 bits. The size of the orbit of v is their quotient.
+  uint64_t order() const;
+  uint64_t stabilizer_order(vect v) const;
+  uint64_t stabilizer_order(vect v, TemporaryStorage &) const;
   vect canonical(vect v, TemporaryStorage &) const;
-  list elements_of_depth(uint64_t depth) const;
-  list elements_of_depth(uint64_t depth, uint64_t max_part) const;
-  list elements_of_evaluation(vect eval) const;
-  uint64_t elements_of_depth_number(uint64_t depth) const;
-  uint64_t elements_of_depth_number(uint64_t depth, uint64_t max_part) const;
+  // The enumerations stop early as asked by the optional control object
+  // (see EnumerationControl), returning the results found so far.
+  list elements_of_depth(uint64_t depth, EnumerationControl *ctl = nullptr) const;
+  list elements_of_depth(uint64_t depth, uint64_t max_part,
+			 EnumerationControl *ctl = nullptr) const;
+  list elements_of_evaluation(vect eval, EnumerationControl *ctl = nullptr) const;
+  // Same as above, the result using the given allocator. With a
+  // Container::ArenaAllocator, all the results are freed at once with the arena.
+  template<class Alloc>
+  std::list<vect, Alloc> elements_of_depth(uint64_t depth, uint64_t max_part,
+					   const Alloc &alloc,
+					   EnumerationControl *ctl = nullptr) const;
+  template<class Alloc>
+  std::list<vect, Alloc> elements_of_evaluation(vect eval, const Alloc &alloc,
+						EnumerationControl *ctl = nullptr) const;
+  uint64_t elements_of_depth_number(uint64_t depth,
+				    EnumerationControl *ctl = nullptr) const;
+  uint64_t elements_of_depth_number(uint64_t depth, uint64_t max_part,
+				    EnumerationControl *ctl = nullptr) const;
+  uint64_t elements_of_evaluation_number(vect eval,
+					 EnumerationControl *ctl = nullptr) const;
+  // Same as elements_of_depth and elements_of_evaluation, each vector coming
+  // with the order of its stabilizer.
+  using stabilizer_list = std::list< std::pair<vect, uint64_t> >;
+  stabilizer_list elements_of_depth_stabilizers(uint64_t depth, uint64_t max_part,
+						EnumerationControl *ctl = nullptr) const {
+    typename ResultStabilizers::type res {this};
+    return elements_of_depth_walk<ResultStabilizers>(depth, max_part, res, ctl);
+  }
+  stabilizer_list elements_of_evaluation_stabilizers(vect eval,
+						     EnumerationControl *ctl = nullptr) const {
+    typename ResultStabilizers::type res {this};
+    return elements_of_evaluation_walk<ResultStabilizers>(eval, res, ctl);
+  }
+
+  // Same as above, the results being written as contiguous rows of the first
+  // N coordinates (see Container::RowCollector). Return the number of rows.
+  using RowCollector = Container::RowCollector<entry>;
+  uint64_t elements_of_depth_rows(uint64_t depth, uint64_t max_part, RowCollector &rows,
+				  EnumerationControl *ctl = nullptr) const {
+    return elements_of_depth_walk<ResultRows>(depth, max_part, rows, ctl);
+  }
+  uint64_t elements_of_evaluation_rows(vect eval, RowCollector &rows,
+				       EnumerationControl *ctl = nullptr) const {
+    return elements_of_evaluation_walk<ResultRows>(eval, rows, ctl);
+  }
+
+  // The enumeration tree of the canonical vectors of sum depth with
+  // coordinates at most max_part (see CanonicalTree). A stopped enumeration
+  // gives a truncated tree.
+  CanonicalTree<vect> elements_of_depth_tree(uint64_t depth, uint64_t max_part,
+					     EnumerationControl *ctl = nullptr) const;
+
+  // Level synchronous enumeration: the element d of the result holds the
+  // canonical vectors of sum d with coordinates at most max_part, for d up to
+  // max_depth, in the same order as elements_of_depth. Each level is computed
+  // from the previous one by a parallel pass over its blocks, their children
+  // being then compacted. A stopped enumeration only returns the complete
+  // levels.
+  using level = std::vector<vect>;
+  std::vector<level> elements_of_depth_levels(uint64_t max_depth, uint64_t max_part,
+					      EnumerationControl *ctl = nullptr) const;
+
+  // Batched canonical and is_canonical on the n rows of the first N
+  // coordinates starting at in, the row i at in + i*stride. The rows are
+  // shared among the Cilk workers, each with its own temporary storage.
+  void canonical_rows(const entry *in, size_t n, size_t stride, entry *out) const {
+    for_each_row(in, n, stride, [this, out](size_t i, vect v, TemporaryStorage &st) {
+	const vect res = canonical(v, st);
+	for (size_t j = 0; j < N; j++) out[i*N + j] = res[j];
+      });
+  }
+  void is_canonical_rows(const entry *in, size_t n, size_t stride, uint8_t *out) const {
+    for_each_row(in, n, stride, [this, out](size_t i, vect v, TemporaryStorage &st) {
+	out[i] = is_canonical(v, st);
+      });
+  }
+
+  // Constraints pruning the enumeration of elements_of_degree. The bounds and
+  // the weights must be constant on the orbits of the group (see orbits) and
+  // the predicate must be invariant under the group. Moreover the predicate
+  // must be monotone: if it holds on a vector it must hold on the vector
+  // obtained by decreasing its last non zero entry. It is evaluated on each
+  // partial vector before the canonical test and must be thread safe.
+  struct Constraints {
+    std::vector<uint64_t> max_part;  // bound on each coordinate (none if empty)
+    std::vector<uint64_t> weight;    // positive weight of each coordinate (1 if empty)
+    std::function<bool(const vect &)> predicate;  // no predicate if empty
+  };
+  // Smallest point of the orbit of each point
+  std::vector<uint64_t> orbits() const;
+  bool is_invariant(const std::vector<uint64_t> &values) const;
+  // Canonical vectors of weighted degree sum(weight[i]*v[i]) == degree. Throw
+  // std::invalid_argument if the constraints are not as above.
+  list elements_of_degree(uint64_t degree, const Constraints &cons,
+			  EnumerationControl *ctl = nullptr) const;
+  template<class Alloc>
+  std::list<vect, Alloc> elements_of_degree(uint64_t degree, const Constraints &cons,
+					    const Alloc &alloc,
+					    EnumerationControl *ctl = nullptr) const;
+  uint64_t elements_of_degree_number(uint64_t degree, const Constraints &cons,
+				     EnumerationControl *ctl = nullptr) const;
 
   template<typename Res> //  should implement the following interface:
   // struct Res {
@@ -135,21 +355,64 @@ public:
   //   static void update(type &res, vect v)   // update res with v
   //   static type_result get_value(type &res) // return value in res
   // };
-  typename Res::type_result elements_of_depth_walk(uint64_t depth, uint64_t max_part) const;
+  typename Res::type_result elements_of_depth_walk(uint64_t depth, uint64_t max_part,
+						   EnumerationControl *ctl = nullptr) const {
+    typename Res::type res {};
+    return elements_of_depth_walk<Res>(depth, max_part, res, ctl);
+  }
+  template<typename Res>
+  typename Res::type_result elements_of_evaluation_walk(vect eval,
+							EnumerationControl *ctl = nullptr) const {
+    typename Res::type res {};
+    return elements_of_evaluation_walk<Res>(eval, res, ctl);
+  }
+  template<typename Res>
+  typename Res::type_result elements_of_degree_walk(uint64_t degree, const Constraints &cons,
+						    EnumerationControl *ctl = nullptr) const {
+    typename Res::type res {};
+    return elements_of_degree_walk<Res>(degree, cons, res, ctl);
+  }
+  // Same as above, accumulating in res
   template<typename Res>
-  typename Res::type_result elements_of_evaluation_walk(vect eval) const;
+  typename Res::type_result elements_of_depth_walk(uint64_t depth, uint64_t max_part,
+						   typename Res::type &res,
+						   EnumerationControl *ctl = nullptr) const;
+  template<typename Res>
+  typename Res::type_result elements_of_evaluation_walk(vect eval, typename Res::type &res,
+							EnumerationControl *ctl = nullptr) const;
+  template<typename Res>
+  typename Res::type_result elements_of_degree_walk(uint64_t degree, const Constraints &cons,
+						    typename Res::type &res,
+						    EnumerationControl *ctl = nullptr) const;
 
   uint64_t first_child_index(const vect &v) const {
     uint64_t res = v.last_non_zero(N);
     if (res >= N) return 0; else return res; }
   vect ith_child(vect v, uint64_t i) const { v.p[i]++; return v; }
 
-  struct ResultList {
-    using type = list_generator;
-    using type_result = list;
+  template<class Alloc>
+  struct ResultListAlloc {
+    using type = list_generator<Alloc>;
+    using type_result = std::list<vect, Alloc>;
     static void update(type &lst, vect v) { lst.push_back(v); }
     static type_result get_value(type &lst) { return CILK_GET_VALUE(lst); }
   };
+  using ResultList = ResultListAlloc< allocator<vect> >;
+
+  // The stabilizer of each vector is computed when emitted, with the
+  // temporary storage of the worker.
+  struct ResultStabilizers {
+    struct type {
+      const PermutationGroup *g;
+      stabilizer_generator lst;
+      BFS_storage store;
+    };
+    using type_result = stabilizer_list;
+    static void update(type &res, vect v) {
+      res.lst.push_back({v, res.g->stabilizer_order(v, res.store.get_store())});
+    }
+    static type_result get_value(type &res) { return CILK_GET_VALUE(res.lst); }
+  };
 
   struct ResultCounter {
     using type = counter;
@@ -158,15 +421,55 @@ public:
     static type_result get_value(type &counter) { return CILK_GET_VALUE(counter); }
   };
 
-  template<class Res>
-  void walk_tree(vect v, typename Res::type &res,
-		 uint64_t target_depth, uint64_t depth, uint64_t max_part,
-		 BFS_storage &store) const;
+  struct ResultRows {
+    using type = RowCollector;
+    using type_result = uint64_t;
+    static void update(type &rows, vect v) { rows.push(v); }
+    static type_result get_value(type &rows) { return rows.finish(); }
+  };
 
+  // The enumeration trees. A Node holds a vector together with the cursor on
+  // its next child. next_child moves the cursor to the next canonical child
+  // and builds it, returning false when there is none left. height bounds the
+  // height of the subtree of a node.
+  struct DepthTree;
+  struct EvaluationTree;
+  struct ConstrainedTree;
+
+  // Walk the subtree of node, which must not be a leaf: its first spawn_levels
+  // levels are spawned as Cilk tasks, the subtrees below are walked
+  // iteratively on an explicit stack.
+  // The walk stops as soon as ctl, if not null, is stopped. depth is the
+  // depth of node in the tree, only used for the statistics and the trace.
+  template<class Res, class Tree>
+  void walk_tree(const Tree &tree, typename Tree::Node node, typename Res::type &res,
+		 BFS_storage &store, EnumerationControl *ctl,
+		 uint64_t depth, uint64_t levels) const;
+  template<class Res, class Tree>
+  void walk_tree_iterative(const Tree &tree, const typename Tree::Node &node,
+			   typename Res::type &res, TemporaryStorage &st,
+			   EnumerationControl *ctl, uint64_t depth) const;
+  // Write the records of the subtree of node of a DepthTree in bits, adding
+  // its leaves to leaves, the first levels being spawned as in walk_tree.
+  // Return false if the subtree is incomplete, the walk being stopped.
+  template<class Tree>
+  bool build_tree(const Tree &tree, typename Tree::Node node, BitStream &bits,
+		  uint64_t &leaves, BFS_storage &store, EnumerationControl *ctl,
+		  uint64_t levels) const;
+  // Counts the canonical tests done since tests to find the next child
+  static void record_children(Statistics &stats, uint64_t depth,
+			      uint64_t tests, bool found) {
+    const uint64_t rejected = stats.canonical_tests - tests - found;
+    if (found) Statistics::add(stats.accepted, depth);
+    if (rejected) Statistics::add(stats.rejected, depth, rejected);
+  }
+  template<class Res, class Tree>
+  typename Res::type_result walk(const Tree &tree, typename Tree::Node root,
+				 typename Res::type &res, EnumerationControl *ctl) const;
   template<class Res>
-  void walk_tree_evaluation(vect v, typename Res::type &res,
-		            vect eval, uint64_t sum_eval,
-		            BFS_storage &store) const;
+  static void emit(typename Res::type &res, const vect &v, EnumerationControl *ctl) {
+    if (not ctl or ctl->take_result()) Res::update(res, v);
+  }
 };
 
 
@@ -189,51 +492,173 @@ bool PermutationGroup<perm>::check_sgs() const {
   return true;
 }
 
+// The transversal elements depend on the strong generating set, but not the
+// smallest element of each of their cosets of the next stabilizer: the
+// element u of the level i is reduced by the levels k > i in turn, replacing
+// u by u*t for the t of the level k minimizing u[t[k]]. The trivial levels
+// are skipped, so that the hash only depends on the group.
 template<class perm>
-bool PermutationGroup<perm>::is_canonical(vect v, TemporaryStorage &st) const {
+uint64_t PermutationGroup<perm>::fingerprint() const {
+  uint64_t res = 0xcbf29ce484222325;  // FNV-1a
+  const auto hash = [&res](uint64_t x) { res = (res ^ x) * 0x100000001b3; };
+  hash(N);
+  for (uint64_t i = 0; i < sgs.size(); i++) {
+    if (sgs[i].size() <= 1) continue;
+    std::vector<perm> reps;
+    for (perm u : sgs[i]) {
+      for (uint64_t k = i + 1; k < sgs.size(); k++) {
+	perm best = u;
+	for (const perm &t : sgs[k])
+	  if (u[t[k]] < best[k]) best = u * t;
+	u = best;
+      }
+      reps.push_back(u);
+    }
+    std::sort(reps.begin(), reps.end());
+    hash(i);
+    hash(reps.size());
+    for (const perm &p : reps)
+      for (uint64_t j = 0; j < N; j++) hash(p[j]);
+  }
+  return res;
+}
+
+// The transversal of the level i is the orbit of i under the strong
+// generators fixing 0..i-1. The chain is complete when all the Schreier
+// generators sift through the levels below; otherwise the non trivial
+// remainder is added to the strong generators, growing the orbit at which
+// it stopped.
+template<class perm>
+auto PermutationGroup<perm>::from_generators(std::string name, uint64_t N,
+					     const std::vector<perm> &gens) -> PermutationGroup {
+  const auto inverse = [](const perm &p) {
+    perm res = perm::one();
+    for (uint64_t k = 0; k < perm::Size; k++) res[p[k]] = k;
+    return res;
+  };
+  const auto fixes = [](const perm &p, uint64_t i) {
+    for (uint64_t k = 0; k < i; k++) if (p[k] != k) return false;
+    return true;
+  };
+  std::vector<perm> strong;
+  for (const perm &g : gens) {
+    assert(g.is_permutation(N));
+    if (g != perm::one()) strong.push_back(g);
+  }
+  StrongGeneratingSet sgs(N);
+  std::vector< std::vector<int64_t> > index(N, std::vector<int64_t>(N));
+  for (bool complete = false; not complete; ) {
+    for (uint64_t i = 0; i < N; i++) {
+      std::vector<perm> &transversal = sgs[i];
+      std::fill(index[i].begin(), index[i].end(), -1);
+      transversal.assign(1, perm::one());
+      index[i][i] = 0;
+      for (size_t k = 0; k < transversal.size(); k++)
+	for (const perm &s : strong)
+	  if (fixes(s, i)) {
+	    const perm u = s * transversal[k];
+	    if (index[i][u[i]] < 0) {
+	      index[i][u[i]] = transversal.size();
+	      transversal.push_back(u);
+	    }
+	  }
+    }
+    complete = true;
+    for (uint64_t i = N; complete and i-- > 0; )
+      for (size_t k = 0; complete and k < sgs[i].size(); k++)
+	for (const perm &s : strong) {
+	  if (not fixes(s, i)) continue;
+	  const perm su = s * sgs[i][k];
+	  perm h = inverse(sgs[i][index[i][su[i]]]) * su;
+	  for (uint64_t j = i+1; j < N and index[j][h[j]] >= 0; j++)
+	    h = inverse(sgs[j][index[j][h[j]]]) * h;
+	  if (h != perm::one()) {
+	    strong.push_back(h);
+	    complete = false;
+	    break;
+	  }
+	}
+  }
+  return PermutationGroup(name, N, sgs);
+}
+
+// Going up the stabilizer chain from the last point, the level i belongs to
+// the symmetric tail if its transversal sends i to each of the N-i remaining
+// points. Then the stabilizer of 0..i-1 has order (N-i)! and is therefore the
+// full symmetric group on i..N-1.
+template<class perm>
+uint64_t PermutationGroup<perm>::symmetric_tail() const {
+  uint64_t level = N-1;
+  for (/**/; level > 0; level--) {
+    const uint64_t i = level-1;
+    if (i >= sgs.size() or sgs[i].size() != N-i) break;
+    std::vector<bool> reached(N, false);
+    for (const perm &p : sgs[i])
+      if (p[i] >= i and p[i] < N) reached[p[i]] = true;
+    if (std::find(reached.begin()+i, reached.end(), false) != reached.end()) break;
+  }
+  return level;
+}
+
+template<class perm>
+bool PermutationGroup<perm>::is_canonical_kernel(vect v, TemporaryStorage &st) const {
+  return is_canonical_generic(v, st, [](uint64_t, uint64_t) {});
+}
+
+template<class perm>
+template<class Reject>
+bool PermutationGroup<perm>::is_canonical_generic(vect v, TemporaryStorage &st,
+						  Reject reject) const {
   set<vect> &to_analyse = st.first;
   set<vect> &new_to_analyse = st.second;
 
+  if (not v.is_revsorted(sym_tail, N)) return canonical_result(false, sym_tail);
   to_analyse.clear();
   new_to_analyse.clear();
   to_analyse.insert(v);
 
-  for (uint64_t i=0; i < N-1; i++) {
+  // The levels of the symmetric tail only permute the coordinates sym_tail..N-1
+  // of vectors having the same multiset of values there, so that the previous
+  // test is enough for them.
+  for (uint64_t i=0; i < sym_tail; i++) {
     new_to_analyse.clear();
     const auto &transversal = sgs[i];
     for (const vect &list_test : to_analyse) {
       // transversal always start with the identity. 
       if (v[i] == list_test[i]) new_to_analyse.insert(list_test);
-      for (auto it = transversal.begin()+1; it != transversal.end(); it++) {
-        const vect child = list_test.permuted(*it);
+      for (uint64_t k = 1; k < transversal.size(); k++) {
+        const vect child = list_test.permuted(transversal[k]);
 	// Slight change from Borie's algorithm's: we do a full lex comparison first.
 	uint64_t first_diff = v.first_diff(child);
-	if ((first_diff < N) and v[first_diff] < child[first_diff]) return false;
+	if ((first_diff < N) and v[first_diff] < child[first_diff]) {
+	  reject(i, k);
+	  return canonical_result(false, i);
+	}
         if (first_diff > i) new_to_analyse.insert(child);
       }
     }
+    // The frontiers too large for the set are expanded by blocks, shared
+    // among the Cilk workers.
+    if (overflowed(new_to_analyse))
+      return is_canonical_parallel(v, st, parallel_frontier, reject);
+    if (statistics().is_enabled())
+      statistics().local().record_frontier(new_to_analyse.size());
     std::swap(to_analyse, new_to_analyse);
   }
-  return true;
+  return canonical_result(true, sym_tail);
 }
 
-// #define SET_SIZE_STATISTIC
-
-#ifdef SET_SIZE_STATISTIC
-size_t set_number = 0;
-size_t set_size = 0;
-#endif
-
 template<>
-bool PermutationGroup<Perm16>::is_canonical(vect v, TemporaryStorage &st) const {
+inline bool PermutationGroup<Perm16>::is_canonical_kernel(vect v, TemporaryStorage &st) const {
   set<vect> &to_analyse = st.first;
   set<vect> &new_to_analyse = st.second;
 
+  if (not v.is_revsorted(sym_tail, N)) return canonical_result(false, sym_tail);
   to_analyse.clear();
   new_to_analyse.clear();
   to_analyse.insert(v);
 
-  for (uint64_t i=0; i < N-1; i++) {
+  for (uint64_t i=0; i < sym_tail; i++) {
     new_to_analyse.clear();
     const auto &transversal = sgs[i];
     for (const vect &list_test : to_analyse) {
@@ -245,17 +670,149 @@ bool PermutationGroup<Perm16>::is_canonical(vect v, TemporaryStorage &st) const
 	const uint64_t diff = ~ unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v.v, child.v)));
 	const uint64_t lt   =   unsigned(_mm_movemask_epi8(_mm_cmplt_epi8(v.v, child.v)));
 	const uint64_t first_diff = diff & (-diff);
-	if (first_diff & lt) return false;
+	if (first_diff & lt) return canonical_result(false, i);
 	if (!(diff & (1<<i))) new_to_analyse.insert(child);
       }
     }
-#ifdef SET_SIZE_STATISTIC
-    set_number++;
-    set_size += new_to_analyse.size();
-#endif
+    if (overflowed(new_to_analyse)) return is_canonical_parallel(v, st);
+    if (statistics().is_enabled())
+      statistics().local().record_frontier(new_to_analyse.size());
     std::swap(to_analyse, new_to_analyse);
   }
-  return true;
+  return canonical_result(true, sym_tail);
+}
+
+
+template<class perm>
+uint64_t PermutationGroup<perm>::order() const {
+  uint64_t res = 1;
+  for (const auto &transversal : sgs) res *= transversal.size();
+  return res;
+}
+
+template<class perm>
+uint64_t PermutationGroup<perm>::stabilizer_order(vect v) const {
+  TemporaryStorage storage;
+  return stabilizer_order(v, storage);
+}
+
+// The elements of the group are the products t_0 * t_1 * ... of elements of
+// the transversals, and their image of v agrees with v on 0..i only if the
+// image by t_0 * ... * t_i does. The frontier of is_canonical counted with
+// multiplicities gives the number of products of the first sym_tail factors
+// fixing v on 0..sym_tail-1. The symmetric tail then permutes the equal
+// coordinates among sym_tail..N-1.
+template<class perm>
+uint64_t PermutationGroup<perm>::stabilizer_order(vect v, TemporaryStorage &st) const {
+  auto &frontier = st.counted;
+  auto &new_frontier = st.new_counted;
+  frontier.assign(1, {v, 1});
+  for (uint64_t i = 0; i < sym_tail; i++) {
+    new_frontier.clear();
+    for (const auto &from : frontier)
+      for (const perm &t : sgs[i]) {
+	const vect image = from.first.permuted(t);
+	if (image[i] == v[i]) new_frontier.push_back({image, from.second});
+      }
+    // Merge the equal images, adding up their multiplicities
+    std::sort(new_frontier.begin(), new_frontier.end(),
+	      [](const std::pair<vect, uint64_t> &a, const std::pair<vect, uint64_t> &b) {
+		return a.first < b.first; });
+    frontier.clear();
+    for (const auto &image : new_frontier)
+      if (not frontier.empty() and frontier.back().first == image.first)
+	frontier.back().second += image.second;
+      else frontier.push_back(image);
+  }
+  uint64_t res = 0;
+  for (const auto &image : frontier) res += image.second;
+  const vect tail = v.revsorted(sym_tail, N);
+  for (uint64_t i = sym_tail, mult = 1; i < N; i++, mult++) {
+    if (i > sym_tail and tail[i] != tail[i-1]) mult = 1;
+    res *= mult;
+  }
+  return res;
+}
+
+// Same as for Perm16 where the comparison bit masks are computed over
+// several registers.
+template<class perm>
+template<class Ops>
+bool PermutationGroup<perm>::is_canonical_mask(vect v, TemporaryStorage &st) const {
+  set<vect> &to_analyse = st.first;
+  set<vect> &new_to_analyse = st.second;
+
+  if (not v.is_revsorted(sym_tail, N)) return canonical_result(false, sym_tail);
+  to_analyse.clear();
+  new_to_analyse.clear();
+  to_analyse.insert(v);
+
+  for (uint64_t i=0; i < sym_tail; i++) {
+    new_to_analyse.clear();
+    const auto &transversal = sgs[i];
+    for (const vect &list_test : to_analyse) {
+      // transversal always start with the identity.
+      if (v[i] == list_test[i]) new_to_analyse.insert(list_test);
+      for (auto it = transversal.begin()+1; it != transversal.end(); it++) {
+        const vect child = Ops::permuted(list_test, *it);
+	const uint64_t diff = Ops::diff_mask(v, child);
+	const uint64_t first_diff = diff & (-diff);
+	if (first_diff & Ops::lt_mask(v, child)) return canonical_result(false, i);
+	if (!(diff & (uint64_t(1)<<i))) new_to_analyse.insert(child);
+      }
+    }
+    if (overflowed(new_to_analyse)) return is_canonical_parallel(v, st);
+    if (statistics().is_enabled())
+      statistics().local().record_frontier(new_to_analyse.size());
+    std::swap(to_analyse, new_to_analyse);
+  }
+  return canonical_result(true, sym_tail);
+}
+
+template<>
+inline bool PermutationGroup<Perm16w>::is_canonical_kernel(vect v, TemporaryStorage &st) const {
+  return is_canonical_mask(v, st);
+}
+template<>
+inline bool PermutationGroup<Perm32>::is_canonical_kernel(vect v, TemporaryStorage &st) const {
+  return is_canonical_mask(v, st);
+}
+template<>
+inline bool PermutationGroup<Perm64>::is_canonical_kernel(vect v, TemporaryStorage &st) const {
+  return is_canonical_mask(v, st);
+}
+
+
+// The canonical tests of Perm16, Perm32 and Perm64 are compiled for each
+// instruction set level in group_kernels.cpp. The kernel matching the processor
+// is selected on the first call (see cpu_dispatch.cpp).
+template<class perm>
+struct CanonicalKernel {
+  using group = PermutationGroup<perm>;
+  using type = bool (*)(const group &, typename group::vect,
+			typename group::TemporaryStorage &);
+  static std::atomic<type> fun;
+};
+
+template<> std::atomic<CanonicalKernel<Perm16>::type> CanonicalKernel<Perm16>::fun;
+template<> std::atomic<CanonicalKernel<Perm32>::type> CanonicalKernel<Perm32>::fun;
+template<> std::atomic<CanonicalKernel<Perm64>::type> CanonicalKernel<Perm64>::fun;
+
+template<class perm>
+bool PermutationGroup<perm>::is_canonical(vect v, TemporaryStorage &st) const {
+  return is_canonical_kernel(v, st);
+}
+template<>
+inline bool PermutationGroup<Perm16>::is_canonical(vect v, TemporaryStorage &st) const {
+  return CanonicalKernel<Perm16>::fun.load(std::memory_order_relaxed)(*this, v, st);
+}
+template<>
+inline bool PermutationGroup<Perm32>::is_canonical(vect v, TemporaryStorage &st) const {
+  return CanonicalKernel<Perm32>::fun.load(std::memory_order_relaxed)(*this, v, st);
+}
+template<>
+inline bool PermutationGroup<Perm64>::is_canonical(vect v, TemporaryStorage &st) const {
+  return CanonicalKernel<Perm64>::fun.load(std::memory_order_relaxed)(*this, v, st);
 }
 
 
@@ -265,16 +822,154 @@ bool PermutationGroup<perm>::is_canonical(vect v) const {
   return is_canonical(v, storage);
 }
 
+// The frontier is kept in a vector, whatever its size. Each block of the
+// frontier keeps its images in its own vector, the vectors being merged,
+// sorted and deduplicated in the next frontier once all the blocks are done.
+template<class perm>
+template<class Test>
+uint64_t PermutationGroup<perm>::expand_frontiers(const vect &v, TemporaryStorage &st,
+						  size_t threshold, Test test,
+						  vect &stop, uint64_t &stop_index) const {
+  static const constexpr size_t block = 64;
+  std::vector<vect> &frontier = st.frontier;
+  std::vector<FrontierBlock> &blocks = st.blocks;
+
+  frontier.assign(1, v);
+  for (uint64_t i=0; i < sym_tail; i++) {
+    const auto &transversal = sgs[i];
+    const size_t n = frontier.size();
+    const size_t nblocks = n > threshold ? (n + block - 1) / block : 1;
+    const size_t len = (n + nblocks - 1) / nblocks;
+    if (blocks.size() < nblocks) blocks.resize(nblocks);
+    for (size_t b = 0; b < nblocks; b++) {
+      blocks[b].images.clear();
+      blocks[b].stopped = false;
+    }
+    std::atomic<bool> stopped(false);
+    cilk_for (size_t b = 0; b < nblocks; b++) {
+      FrontierBlock &out = blocks[b];
+      const size_t end = std::min(n, (b + 1) * len);
+      for (size_t k = b * len; k < end; k++) {
+	if (stopped.load(std::memory_order_relaxed)) break;
+	const vect &list_test = frontier[k];
+	// transversal always start with the identity.
+	if (v[i] == list_test[i]) out.images.push_back(list_test);
+	for (uint64_t t = 1; t < transversal.size(); t++) {
+	  const vect child = list_test.permuted(transversal[t]);
+	  const int res = test(i, child);
+	  if (res < 0) {
+	    out.stop = child;
+	    out.stop_index = t;
+	    out.stopped = true;
+	    stopped.store(true, std::memory_order_relaxed);
+	    break;
+	  }
+	  if (res > 0) out.images.push_back(child);
+	}
+      }
+    }
+    if (stopped) {
+      bool found = false;
+      for (size_t b = 0; b < nblocks; b++)
+	if (blocks[b].stopped and (not found or stop < blocks[b].stop)) {
+	  stop = blocks[b].stop;
+	  stop_index = blocks[b].stop_index;
+	  found = true;
+	}
+      return i;
+    }
+    frontier.clear();
+    for (size_t b = 0; b < nblocks; b++)
+      frontier.insert(frontier.end(), blocks[b].images.begin(), blocks[b].images.end());
+    std::sort(frontier.begin(), frontier.end());
+    frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+    if (statistics().is_enabled())
+      statistics().local().record_frontier(frontier.size());
+  }
+  return sym_tail;
+}
+
+template<class perm>
+bool PermutationGroup<perm>::is_canonical_parallel(vect v, TemporaryStorage &st,
+						   size_t threshold) const {
+  return is_canonical_parallel(v, st, threshold, [](uint64_t, uint64_t) {});
+}
+
+// Only the largest rejecting image found by the workers is passed to reject.
+template<class perm>
+template<class Reject>
+bool PermutationGroup<perm>::is_canonical_parallel(vect v, TemporaryStorage &st,
+						   size_t threshold, Reject reject) const {
+  if (not v.is_revsorted(sym_tail, N)) return canonical_result(false, sym_tail);
+  vect stop;
+  uint64_t stop_index;
+  const uint64_t level = expand_frontiers(v, st, threshold,
+    [this, &v](uint64_t i, const vect &child) -> int {
+      const uint64_t first_diff = v.first_diff(child);
+      if ((first_diff < N) and v[first_diff] < child[first_diff]) return -1;
+      return first_diff > i;
+    }, stop, stop_index);
+  if (level < sym_tail) reject(level, stop_index);
+  return canonical_result(level == sym_tail, level);
+}
+
+// A larger image restarts the search from its canonical tail, as in canonical.
+template<class perm>
+auto PermutationGroup<perm>::canonical_parallel(vect v, TemporaryStorage &st,
+						size_t threshold) const -> vect {
+  const auto test = [this, &v](uint64_t i, const vect &child) -> int {
+    if (v < child) return -1;
+    return v.first_diff(child) > i;
+  };
+  vect larger;
+  uint64_t index;
+  v = v.revsorted(sym_tail, N);
+  while (expand_frontiers(v, st, threshold, test, larger, index) < sym_tail)
+    v = larger.revsorted(sym_tail, N);
+  return v;
+}
+
+// The children are the ones tested by the depth tree, the rejections being
+// counted for the current order of the transversals. The sort is stable, so
+// that the transversals are unchanged if no child is rejected.
+template<class perm>
+void PermutationGroup<perm>::sort_transversals(uint64_t depth, uint64_t max_part) {
+  if (depth == 0) return;
+  std::vector< std::vector<uint64_t> > rejections;
+  for (const auto &transversal : sgs) rejections.emplace_back(transversal.size(), 0);
+  TemporaryStorage st;
+  for (const level &parents : elements_of_depth_levels(depth - 1, max_part))
+    for (const vect &v : parents)
+      for (uint64_t j = first_child_index(v); j < N; j++)
+	if (v[j] < max_part)
+	  is_canonical_generic(ith_child(v, j), st, [&rejections](uint64_t i, uint64_t k) {
+	      rejections[i][k]++;
+	    });
+
+  for (uint64_t i = 0; i < sgs.size(); i++) {
+    std::vector<uint64_t> order(sgs[i].size());
+    for (uint64_t k = 0; k < order.size(); k++) order[k] = k;
+    const std::vector<uint64_t> &count = rejections[i];
+    if (order.size() > 2)
+      std::stable_sort(order.begin() + 1, order.end(),
+		       [&count](uint64_t a, uint64_t b) { return count[a] > count[b]; });
+    std::vector<perm> transversal;
+    for (uint64_t k : order) transversal.push_back(sgs[i][k]);
+    sgs[i] = std::move(transversal);
+  }
+}
+
 template<class perm>
 auto PermutationGroup<perm>::canonical(vect v, TemporaryStorage &st) const -> vect {
   set<vect> &to_analyse = st.first;
   set<vect> &new_to_analyse = st.second;
 
+  v = v.revsorted(sym_tail, N);
   to_analyse.clear();
   new_to_analyse.clear();
   to_analyse.insert(v);
 
-  for (uint64_t i=0; i < N-1; i++) {
+  for (uint64_t i=0; i < sym_tail; i++) {
     new_to_analyse.clear();
     const auto &transversal = sgs[i];
     for (const vect &list_test : to_analyse) {
@@ -289,6 +984,7 @@ auto PermutationGroup<perm>::canonical(vect v, TemporaryStorage &st) const -> ve
 	else if (v.first_diff(child) > i) new_to_analyse.insert(child);
       }
     }
+    if (overflowed(new_to_analyse)) return canonical_parallel(v, st);
     std::swap(to_analyse, new_to_analyse);
   }
   return v;
@@ -301,116 +997,505 @@ auto PermutationGroup<perm>::canonical(vect v) const -> vect {
 }
 
 template<class perm>
-template<class Res>
-void PermutationGroup<perm>::walk_tree(vect v, typename Res::type &res,
-       uint64_t target_depth, uint64_t depth, uint64_t max_part,
-       BFS_storage &store) const {
-  if (depth == target_depth) Res::update(res, v);
-  else {
-    uint64_t i=first_child_index(v);
-    if (v[i]>=max_part) i++;
-    for (/**/; i<N; i++) {
-      vect child = ith_child(v, i);
-      if (is_canonical(child, store.get_store()))
-	cilk_spawn this->walk_tree<Res>(child, res, target_depth, depth+1, max_part, store);
+template<class F>
+void PermutationGroup<perm>::for_each_row(const entry *in, size_t n, size_t stride,
+					  F f) const {
+  static const constexpr size_t block = 1024;
+  BFS_storage store;
+  cilk_for (size_t b = 0; b < n; b += block) {
+    TemporaryStorage &st = store.get_store();
+    const size_t end = std::min(n, b + block);
+    for (size_t i = b; i < end; i++) {
+      vect v;
+      for (size_t j = 0; j < vect::Size; j++) v[j] = j < N ? in[i*stride + j] : 0;
+      f(i, v, st);
     }
   }
 }
 
+template<class perm>
+template<class Res, class Tree>
+void PermutationGroup<perm>::walk_tree(const Tree &tree, typename Tree::Node node,
+				       typename Res::type &res, BFS_storage &store,
+				       EnumerationControl *ctl,
+				       uint64_t depth, uint64_t levels) const {
+  if (levels == 0) {
+    walk_tree_iterative<Res>(tree, node, res, store.get_store(), ctl, depth);
+    return;
+  }
+  const bool stats = statistics().is_enabled();
+  if (stats) Statistics::add(statistics().local().nodes, depth);
+  TraceTask task("task", depth, node.v, N);
+  typename Tree::Node child;
+  // The storage and statistics are fetched again after each spawn since the
+  // continuation may have been stolen by another worker.
+  while (true) {
+    Statistics *local = stats ? &statistics().local() : nullptr;
+    const uint64_t tests = local ? local->canonical_tests : 0;
+    const bool found = tree.next_child(node, child, store.get_store());
+    if (local) record_children(*local, depth+1, tests, found);
+    if (not found or (ctl and ctl->poll())) break;
+    if (tree.is_leaf(child)) emit<Res>(res, child.v, ctl);
+    else {
+      const uint64_t time = task.spawn();
+      cilk_spawn this->walk_tree<Res>(tree, child, res, store, ctl, depth+1, levels-1);
+      task.resume(time);
+    }
+  }
+  const uint64_t time = task.sync();
+  cilk_sync;
+  task.resume(time);
+}
 
 template<class perm>
-template<class Res>
+template<class Res, class Tree>
+void PermutationGroup<perm>::walk_tree_iterative(const Tree &tree,
+						 const typename Tree::Node &node,
+						 typename Res::type &res,
+						 TemporaryStorage &st,
+						 EnumerationControl *ctl,
+						 uint64_t depth) const {
+  // No spawn below, the thread doesn't change
+  Statistics *stats = statistics().is_enabled() ? &statistics().local() : nullptr;
+  TraceTask task("subtree", depth, node.v, N);
+  std::vector<typename Tree::Node> stack;
+  stack.reserve(tree.height(node));
+  stack.push_back(node);
+  if (stats) Statistics::add(stats->nodes, depth);
+  typename Tree::Node child;
+  uint64_t nodes = 0;
+  while (not stack.empty()) {
+    if (ctl and (++nodes % EnumerationControl::poll_period == 0 ?
+		 ctl->poll() : ctl->stopped())) return;
+    const uint64_t child_depth = depth + stack.size();
+    const uint64_t tests = stats ? stats->canonical_tests : 0;
+    const bool found = tree.next_child(stack.back(), child, st);
+    if (stats) record_children(*stats, child_depth, tests, found);
+    if (not found) stack.pop_back();
+    else if (tree.is_leaf(child)) emit<Res>(res, child.v, ctl);
+    else {
+      stack.push_back(child);
+      if (stats) Statistics::add(stats->nodes, child_depth);
+    }
+  }
+}
+
+template<class perm>
+template<class Res, class Tree>
 typename Res::type_result
-PermutationGroup<perm>::elements_of_depth_walk(uint64_t depth, uint64_t max_part) const {
-  vect zero_vect {};
-  typename Res::type res {};
-  BFS_storage store {};
-#ifdef SET_SIZE_STATISTIC
-  set_number = 0;
-  set_size = 0;
-#endif
-  walk_tree<Res>(zero_vect, res, depth, 0, max_part, store);
-#ifdef SET_SIZE_STATISTIC
-  std::cout << "Number of sets = "<<set_number <<
-    ", Mean size = " << 1.*set_size / set_number << std::endl;
-#endif
+PermutationGroup<perm>::walk(const Tree &tree, typename Tree::Node root,
+			     typename Res::type &res, EnumerationControl *ctl) const {
+  if (ctl and ctl->poll()) return Res::get_value(res);
+  const bool stats = statistics().is_enabled();
+  const auto start = std::chrono::steady_clock::now();
+  if (tree.is_leaf(root)) emit<Res>(res, root.v, ctl);
+  else {
+    BFS_storage store {};
+    TraceTask task("enumeration", 0, root.v, N);
+    walk_tree<Res>(tree, root, res, store, ctl, 0, spawn_levels);
+  }
+  if (stats)
+    statistics().local().nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
   return Res::get_value(res);
 }
 
 
 template<class perm>
-auto PermutationGroup<perm>::elements_of_depth(uint64_t depth) const -> list {
-  return elements_of_depth_walk<ResultList>(depth, depth);
-}
+struct PermutationGroup<perm>::DepthTree {
+  const PermutationGroup &g;
+  const uint64_t target_depth, max_part;
+
+  struct Node {
+    vect v;
+    uint64_t depth, i;
+  };
+  Node root() const { return {vect {}, 0, 0}; }
+  bool is_leaf(const Node &n) const { return n.depth == target_depth; }
+  uint64_t height(const Node &n) const { return target_depth - n.depth; }
+  bool next_child(Node &n, Node &child, TemporaryStorage &st) const {
+    for (; n.i < g.N; n.i++) {
+      if (n.v[n.i] >= max_part) continue;
+      // v being canonical, its symmetric tail is non increasing
+      if (n.i > g.sym_tail and n.v[n.i-1] == n.v[n.i]) continue;
+      child.v = g.ith_child(n.v, n.i);
+      if (g.is_canonical(child.v, st)) {
+	// i is the last non zero entry of the child
+	child.depth = n.depth + 1;
+	child.i = n.i++;
+	return true;
+      }
+    }
+    return false;
+  }
+};
+
 template<class perm>
-auto PermutationGroup<perm>::elements_of_depth(uint64_t depth,
-					       uint64_t max_part) const -> list {
-  return elements_of_depth_walk<ResultList>(depth, max_part);
+template<class Res>
+typename Res::type_result
+PermutationGroup<perm>::elements_of_depth_walk(uint64_t depth, uint64_t max_part,
+					       typename Res::type &res,
+					       EnumerationControl *ctl) const {
+  const DepthTree tree {*this, depth, max_part};
+  return walk<Res>(tree, tree.root(), res, ctl);
 }
 
+
+// The record of a node, the mask of its canonical children, is written before
+// their subtrees. A subtree without leaves is then removed from the end of
+// the stream and its bit cleared in the mask of its parent. With Cilk, the
+// subtrees of the first levels are written to their own streams, appended in
+// order after the sync up to the first incomplete one, so that the missing
+// records are always at the end.
 template<class perm>
-uint64_t PermutationGroup<perm>::elements_of_depth_number(uint64_t depth) const {
-  return elements_of_depth_walk<ResultCounter>(depth, depth);
+template<class Tree>
+bool PermutationGroup<perm>::build_tree(const Tree &tree,
+					typename Tree::Node node, BitStream &bits,
+					uint64_t &leaves, BFS_storage &store,
+					EnumerationControl *ctl, uint64_t levels) const {
+  using Node = typename Tree::Node;
+  // Write the record of n, return the mask of its children which are not leaves
+  const auto expand = [&](Node n, TemporaryStorage &st) -> uint64_t {
+    const uint64_t first = n.i;
+    uint64_t mask = 0;
+    Node child;
+    while (tree.next_child(n, child, st)) mask |= uint64_t(1) << child.i;
+    bits.write(mask >> first, N - first);
+    if (n.depth + 1 < tree.target_depth) return mask;
+    leaves += __builtin_popcountll(mask);
+    return 0;
+  };
+  const auto child_of = [this](const Node &n, uint64_t i) -> Node {
+    return {ith_child(n.v, i), n.depth + 1, i};
+  };
+  const uint64_t record = bits.size(), leaves_before = leaves;
+
+  if (levels > 0) {
+    uint64_t mask = expand(node, store.get_store());
+    std::vector<Node> children;
+    for (; mask; mask &= mask - 1) children.push_back(child_of(node, __builtin_ctzll(mask)));
+    std::vector<BitStream> parts(children.size());
+    std::vector<uint64_t> counts(children.size(), 0);
+    std::unique_ptr<bool[]> complete(new bool[children.size()]);
+    for (size_t k = 0; k < children.size(); k++)
+      complete[k] = cilk_spawn this->build_tree(tree, children[k], parts[k], counts[k],
+						store, ctl, levels-1);
+    cilk_sync;
+    for (size_t k = 0; k < children.size(); k++) {
+      if (counts[k] == 0 and complete[k]) bits.reset(record + children[k].i - node.i);
+      bits.append(parts[k]);
+      leaves += counts[k];
+      if (not complete[k]) return false;
+    }
+    if (leaves == leaves_before) bits.truncate(record);
+    return true;
+  }
+
+  struct Frame { Node node; uint64_t mask, record, leaves; };
+  TemporaryStorage &st = store.get_store();
+  std::vector<Frame> stack;
+  stack.reserve(tree.height(node));
+  stack.push_back({node, expand(node, st), record, leaves_before});
+  uint64_t nodes = 0;
+  while (not stack.empty()) {
+    if (ctl and (++nodes % EnumerationControl::poll_period == 0 ?
+		 ctl->poll() : ctl->stopped())) return false;
+    Frame &f = stack.back();
+    if (f.mask == 0) {
+      if (f.leaves == leaves) {
+	bits.truncate(f.record);
+	if (stack.size() > 1) {
+	  const Frame &parent = stack[stack.size() - 2];
+	  bits.reset(parent.record + f.node.i - parent.node.i);
+	}
+      }
+      stack.pop_back();
+      continue;
+    }
+    const Node child = child_of(f.node, __builtin_ctzll(f.mask));
+    f.mask &= f.mask - 1;
+    const uint64_t child_record = bits.size(), child_leaves = leaves;
+    stack.push_back({child, expand(child, st), child_record, child_leaves});
+  }
+  return true;
 }
+
 template<class perm>
-uint64_t PermutationGroup<perm>::elements_of_depth_number(uint64_t depth,
-							  uint64_t max_part) const {
-  return elements_of_depth_walk<ResultCounter>(depth, max_part);
+auto PermutationGroup<perm>::elements_of_depth_tree(uint64_t depth, uint64_t max_part,
+						    EnumerationControl *ctl) const
+  -> CanonicalTree<vect> {
+  CanonicalTree<vect> res(N, depth, max_part);
+  const DepthTree tree {*this, depth, max_part};
+  if (depth == 0) res.leaves = 1;
+  else if (ctl and ctl->poll()) res.truncated = true;
+  else {
+    BFS_storage store {};
+    TraceTask task("enumeration", 0, tree.root().v, N);
+    res.truncated = not build_tree(tree, tree.root(), res.bits, res.leaves,
+				   store, ctl, spawn_levels);
+  }
+  return res;
 }
 
+// The cursor of a node of the depth tree is its last non zero coordinate,
+// so that the levels only keep the vectors. The children are tested one by
+// one by DepthTree::next_child with the dispatched kernels: a canonical test
+// batched over the children of a node did fewer permutations but measured
+// slower (see TODO).
 template<class perm>
-template<class Res>
-void PermutationGroup<perm>::walk_tree_evaluation(vect v, typename Res::type &res,
-						  vect eval, uint64_t sum_eval,
-				                  BFS_storage &store) const {
-  // Invariant: sum = sum(eval)
-  if (sum_eval == eval[0]) { Res::update(res, v); return;}
-  uint64_t first = v.last_non_zero(N);
-  if (first >= N) first = 0;
-  else            first++;
-  // std::cout << v << " eval = " << eval << ", sum = " << sum_eval << std::endl;
-  for (uint64_t i=0; i<=eval[0]; i++) {
-    for (uint64_t ival=1; ival<N; ival++) {
-      if (eval[ival] > 0) {
-	vect child = v;
-	child[first+i] = ival;
-	vect new_eval = eval;
-	new_eval[ival]--;
-	new_eval[0] -= i;
-	if (is_canonical(child, store.get_store())) {
-	  cilk_spawn this->walk_tree_evaluation<Res>(child, res, new_eval,
-						     sum_eval-1-i, store);
+auto PermutationGroup<perm>::elements_of_depth_levels(uint64_t max_depth, uint64_t max_part,
+						      EnumerationControl *ctl) const
+  -> std::vector<level> {
+  static const constexpr size_t block = 1024;
+  std::vector<level> res(1, level(1, vect {}));
+  if (ctl and (ctl->poll() or not ctl->take_result())) return {};
+  const DepthTree tree {*this, max_depth, max_part};
+  const bool stats = statistics().is_enabled();
+  BFS_storage store;
+  for (uint64_t depth = 0; depth < max_depth; depth++) {
+    const level &parents = res.back();
+    const size_t n = parents.size(), nblocks = (n + block - 1) / block;
+    if (n == 0) {
+      res.emplace_back();
+      continue;
+    }
+    TraceTask task("level", depth, parents[0], N);
+    std::vector<level> children(nblocks);
+    cilk_for (size_t b = 0; b < n; b += block) {
+      if (ctl and ctl->poll()) continue;
+      TemporaryStorage &st = store.get_store();
+      Statistics *local = stats ? &statistics().local() : nullptr;
+      level &out = children[b / block];
+      const size_t end = std::min(n, b + block);
+      for (size_t k = b; k < end; k++) {
+	typename DepthTree::Node node {parents[k], depth, N}, child;
+	while (node.i > 0 and node.v[node.i - 1] == 0) node.i--;
+	if (node.i > 0) node.i--;
+	if (local) Statistics::add(local->nodes, depth);
+	while (true) {
+	  const uint64_t tests = local ? local->canonical_tests : 0;
+	  const bool found = tree.next_child(node, child, st);
+	  if (local) record_children(*local, depth+1, tests, found);
+	  if (not found or (ctl and not ctl->take_result())) break;
+	  out.push_back(child.v);
 	}
       }
     }
+    if (ctl and ctl->stopped()) break;
+    std::vector<size_t> offsets(nblocks + 1, 0);
+    for (size_t b = 0; b < nblocks; b++) offsets[b+1] = offsets[b] + children[b].size();
+    res.emplace_back(offsets.back());
+    level &next = res.back();
+    cilk_for (size_t b = 0; b < nblocks; b++)
+      std::copy(children[b].begin(), children[b].end(), next.begin() + offsets[b]);
   }
+  return res;
+}
+
+template<class perm>
+template<class Alloc>
+auto PermutationGroup<perm>::elements_of_depth(uint64_t depth, uint64_t max_part,
+					       const Alloc &alloc,
+					       EnumerationControl *ctl) const -> std::list<vect, Alloc> {
+  typename ResultListAlloc<Alloc>::type res {std::list<vect, Alloc>(alloc)};
+  return elements_of_depth_walk< ResultListAlloc<Alloc> >(depth, max_part, res, ctl);
+}
+template<class perm>
+template<class Alloc>
+auto PermutationGroup<perm>::elements_of_evaluation(vect eval, const Alloc &alloc,
+						    EnumerationControl *ctl) const -> std::list<vect, Alloc> {
+  typename ResultListAlloc<Alloc>::type res {std::list<vect, Alloc>(alloc)};
+  return elements_of_evaluation_walk< ResultListAlloc<Alloc> >(eval, res, ctl);
+}
+template<class perm>
+template<class Alloc>
+auto PermutationGroup<perm>::elements_of_degree(uint64_t degree, const Constraints &cons,
+						const Alloc &alloc,
+						EnumerationControl *ctl) const -> std::list<vect, Alloc> {
+  typename ResultListAlloc<Alloc>::type res {std::list<vect, Alloc>(alloc)};
+  return elements_of_degree_walk< ResultListAlloc<Alloc> >(degree, cons, res, ctl);
+}
+
+template<class perm>
+auto PermutationGroup<perm>::elements_of_depth(uint64_t depth,
+					       EnumerationControl *ctl) const -> list {
+  return elements_of_depth_walk<ResultList>(depth, depth, ctl);
 }
+template<class perm>
+auto PermutationGroup<perm>::elements_of_depth(uint64_t depth, uint64_t max_part,
+					       EnumerationControl *ctl) const -> list {
+  return elements_of_depth_walk<ResultList>(depth, max_part, ctl);
+}
+
+template<class perm>
+uint64_t PermutationGroup<perm>::elements_of_depth_number(uint64_t depth,
+							  EnumerationControl *ctl) const {
+  return elements_of_depth_walk<ResultCounter>(depth, depth, ctl);
+}
+template<class perm>
+uint64_t PermutationGroup<perm>::elements_of_depth_number(uint64_t depth, uint64_t max_part,
+							  EnumerationControl *ctl) const {
+  return elements_of_depth_walk<ResultCounter>(depth, max_part, ctl);
+}
+
+// Orderly generation of the vectors of given content: the coordinates are
+// filled from left to right, each child placing a non zero value after some
+// of the remaining zeros. The children are generated in increasing order so
+// that for each position, the values are tried increasingly.
+template<class perm>
+struct PermutationGroup<perm>::EvaluationTree {
+  const PermutationGroup &g;
+
+  // Invariant: v is zero on pos..N-1 and eval is the content to be put there.
+  // The next child puts the value ival at position q.
+  struct Node {
+    vect v, eval;
+    uint64_t pos, q, ival;
+  };
+  Node root(vect eval) const { return {vect {}, eval, 0, 0, 1}; }
+  bool is_leaf(const Node &n) const { return n.pos + n.eval[0] == g.N; }
+  uint64_t height(const Node &n) const { return g.N - n.pos - n.eval[0]; }
+  bool next_child(Node &n, Node &child, TemporaryStorage &st) const {
+    for (; n.q <= n.pos + n.eval[0]; n.q++, n.ival = 1) {
+      // v being canonical, its symmetric tail is non increasing: a zero can't
+      // be followed by a non zero value there.
+      if (n.q > n.pos and n.q > g.sym_tail) return false;
+      const uint64_t max_val = (n.q == n.pos and n.q > g.sym_tail) ? n.v[n.q-1] : g.N-1;
+      for (; n.ival <= max_val; n.ival++) {
+	if (n.eval[n.ival] == 0) continue;
+	child.v = n.v;
+	child.v[n.q] = n.ival;
+	// Decreasing the last non zero entry of a canonical vector keeps it
+	// canonical, so that the larger values at q are not canonical either.
+	if (not g.is_canonical(child.v, st)) break;
+	child.eval = n.eval;
+	child.eval[n.ival]--;
+	child.eval[0] -= n.q - n.pos;
+	child.pos = child.q = n.q + 1;
+	child.ival = 1;
+	n.ival++;
+	return true;
+      }
+    }
+    return false;
+  }
+};
 
 template<class perm>
 template<class Res>
 typename Res::type_result
-PermutationGroup<perm>::elements_of_evaluation_walk(vect eval) const {
-  vect zero_vect {};
+PermutationGroup<perm>::elements_of_evaluation_walk(vect eval, typename Res::type &res,
+						    EnumerationControl *ctl) const {
   uint64_t sum = 0;
-  typename Res::type res {};
-  BFS_storage store {};
-#ifdef SET_SIZE_STATISTIC
-  set_number = 0;
-  set_size = 0;
-#endif
   for (size_t i=0; i<N; i++) { sum+=eval[i]; }
   assert(sum == N);
-  walk_tree_evaluation<Res>(zero_vect, res, eval, sum, store);
-#ifdef SET_SIZE_STATISTIC
-  std::cout << "Number of sets = "<<set_number <<
-    ", Mean size = " << 1.*set_size / set_number << std::endl;
-#endif
-  return Res::get_value(res);
+  const EvaluationTree tree {*this};
+  return walk<Res>(tree, tree.root(eval), res, ctl);
+}
+
+template<class perm>
+auto PermutationGroup<perm>::elements_of_evaluation(vect eval,
+						    EnumerationControl *ctl) const -> list {
+  return elements_of_evaluation_walk<ResultList>(eval, ctl);
+}
+template<class perm>
+uint64_t PermutationGroup<perm>::elements_of_evaluation_number(vect eval,
+							       EnumerationControl *ctl) const {
+  return elements_of_evaluation_walk<ResultCounter>(eval, ctl);
+}
+
+template<class perm>
+std::vector<uint64_t> PermutationGroup<perm>::orbits() const {
+  std::vector<uint64_t> orb(N);
+  for (uint64_t i=0; i<N; i++) orb[i] = i;
+  // The transversals generate the group: merge the orbits until stable
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &transversal : sgs)
+      for (const perm &p : transversal)
+	for (uint64_t i=0; i<N; i++) {
+	  const uint64_t m = std::min(orb[i], orb[p[i]]);
+	  if (orb[i] != m or orb[p[i]] != m) { orb[i] = orb[p[i]] = m; changed = true; }
+	}
+  }
+  return orb;
+}
+
+template<class perm>
+bool PermutationGroup<perm>::is_invariant(const std::vector<uint64_t> &values) const {
+  if (values.size() < N) return false;
+  for (const auto &transversal : sgs)
+    for (const perm &p : transversal)
+      for (uint64_t i=0; i<N; i++)
+	if (values[p[i]] != values[i]) return false;
+  return true;
+}
+
+// Same tree as DepthTree: the parent of a vector satisfying the constraints
+// satisfies them, so that the subtrees are cut as soon as they fail.
+template<class perm>
+struct PermutationGroup<perm>::ConstrainedTree {
+  const PermutationGroup &g;
+  const uint64_t degree;
+  const Constraints &cons;
+
+  struct Node {
+    vect v;
+    uint64_t wdegree, i;
+  };
+  Node root() const { return {vect {}, 0, 0}; }
+  bool is_leaf(const Node &n) const { return n.wdegree == degree; }
+  // The weights are positive
+  uint64_t height(const Node &n) const { return degree - n.wdegree; }
+  bool next_child(Node &n, Node &child, TemporaryStorage &st) const {
+    for (; n.i < g.N; n.i++) {
+      if (n.v[n.i] >= cons.max_part[n.i] or n.wdegree + cons.weight[n.i] > degree) continue;
+      // v being canonical, its symmetric tail is non increasing
+      if (n.i > g.sym_tail and n.v[n.i-1] == n.v[n.i]) continue;
+      child.v = g.ith_child(n.v, n.i);
+      if (cons.predicate and not cons.predicate(child.v)) continue;
+      if (g.is_canonical(child.v, st)) {
+	child.wdegree = n.wdegree + cons.weight[n.i];
+	child.i = n.i++;
+	return true;
+      }
+    }
+    return false;
+  }
+};
+
+template<class perm>
+template<class Res>
+typename Res::type_result
+PermutationGroup<perm>::elements_of_degree_walk(uint64_t degree, const Constraints &cons,
+						typename Res::type &res,
+						EnumerationControl *ctl) const {
+  Constraints full = cons;
+  if (full.max_part.empty()) full.max_part.assign(N, degree);
+  if (full.weight.empty()) full.weight.assign(N, 1);
+  if (full.max_part.size() != N or full.weight.size() != N)
+    throw std::invalid_argument("The bounds and the weights should have N entries");
+  if (not is_invariant(full.max_part) or not is_invariant(full.weight))
+    throw std::invalid_argument("The bounds and the weights should be constant on the orbits");
+  if (std::find(full.weight.begin(), full.weight.end(), 0) != full.weight.end())
+    throw std::invalid_argument("The weights should be positive");
+  const ConstrainedTree tree {*this, degree, full};
+  if (full.predicate and not full.predicate(tree.root().v))
+    return Res::get_value(res);
+  return walk<Res>(tree, tree.root(), res, ctl);
 }
 
 template<class perm>
-auto PermutationGroup<perm>::elements_of_evaluation(vect eval) const -> list {
-  return elements_of_evaluation_walk<ResultList>(eval);
+auto PermutationGroup<perm>::elements_of_degree(uint64_t degree, const Constraints &cons,
+						EnumerationControl *ctl) const -> list {
+  return elements_of_degree_walk<ResultList>(degree, cons, ctl);
+}
+template<class perm>
+uint64_t PermutationGroup<perm>::elements_of_degree_number(uint64_t degree,
+							   const Constraints &cons,
+							   EnumerationControl *ctl) const {
+  return elements_of_degree_walk<ResultCounter>(degree, cons, ctl);
 }
 
 } //  namespace IVMPG
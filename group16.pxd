@@ -19,6 +19,8 @@ from libcpp.vector cimport vector as stl_vector
 from libcpp.string cimport string as stl_string
 from libcpp.list cimport list as stl_list
 
+ctypedef void (*RowSink)(void *context, stl_vector[uint8_t] &rows) noexcept
+
 cdef extern from "group16.hpp" namespace "IVMPG" nogil:
     cdef cppclass Vect16:
         uint8_t &operator[](int)
@@ -34,6 +36,40 @@ cdef extern from "group16.hpp" namespace "IVMPG" nogil:
 
     ctypedef stl_vector[ stl_vector[Perm16] ] StrongGeneratingSet
 
+    cdef cppclass Statistics:
+        stl_vector[uint64_t] nodes, accepted, rejected
+        uint64_t canonical_tests
+        stl_vector[uint64_t] rejection_level, frontier_sizes
+        uint64_t frontiers, frontier_total
+        uint64_t requests, inserted, collisions, max_probe
+        stl_vector[uint64_t] probe_lengths
+        uint64_t nanoseconds
+
+    cdef cppclass StatisticsRegistry:
+        bint is_enabled() const
+        void enable(bint b)
+        Statistics collect() const
+        void reset()
+
+    StatisticsRegistry &statistics()
+
+    cdef cppclass Tracer:
+        bint is_enabled() const
+        void enable(size_t capacity)
+        void disable()
+        void reset()
+        uint64_t dropped() const
+        bint write_json(stl_string filename) const
+
+    Tracer &tracer()
+
+    cdef cppclass EnumerationControl:
+        uint64_t max_results
+        void set_timeout_seconds(double seconds)
+        void cancel()
+        bint truncated() const
+        uint64_t results() const
+
     # I have to redeclare the stl::list as I use a non standard allocator
     cdef cppclass PG16listIterator "IVMPG::PermutationGroup16::list::iterator":
         bint operator==(PG16listIterator) nogil
@@ -46,14 +82,29 @@ cdef extern from "group16.hpp" namespace "IVMPG" nogil:
         PG16listIterator end()
 
 
+    cdef cppclass RowCollector16 "IVMPG::PermutationGroup16::RowCollector":
+        RowCollector16(size_t width)
+        RowCollector16(size_t width, size_t chunk_rows, RowSink sink, void *context)
+        stl_vector[uint8_t] &buffer()
+
     cdef cppclass PermutationGroup16 nogil:
 
         PermutationGroup16(stl_string name, uint64_t N, StrongGeneratingSet sgs)
+        uint64_t N
 
         Vect16 canonical(Vect16 v) const
         bint is_canonical(Vect16 v) const
         bint check_sgs() const
+        void sort_transversals(uint64_t depth, uint64_t max_part) except +
 
         PG16list elements_of_depth(uint64_t depth) const
+        PG16list elements_of_depth(uint64_t depth, EnumerationControl *ctl) const
         PG16list elements_of_evaluation(Vect16 v) except +
+        PG16list elements_of_evaluation(Vect16 v, EnumerationControl *ctl) except +
+        void canonical_rows(const uint8_t *inp, size_t n, size_t stride, uint8_t *out) const
+        void is_canonical_rows(const uint8_t *inp, size_t n, size_t stride, uint8_t *out) const
+        uint64_t elements_of_depth_rows(uint64_t depth, uint64_t max_part,
+                                        RowCollector16 &rows, EnumerationControl *ctl) except +
+        uint64_t elements_of_evaluation_rows(Vect16 v, RowCollector16 &rows,
+                                             EnumerationControl *ctl) except +
 
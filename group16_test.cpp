@@ -30,7 +30,10 @@
 
 #include "group16.hpp"
 #include "group_examples.hpp"
+#include "packed_file.hpp"
+#include "enumeration_cache.hpp"
 #include <iostream>
+#include <cstdio>
 
 //____________________________________________________________________________//
 
@@ -66,6 +69,75 @@ BOOST_AUTO_TEST_CASE( elements_of_depth_test )
   BOOST_CHECK_EQUAL( g_Borie.elements_of_depth(20).size(),   57605u ); // Checked with Sage
 }
 
+BOOST_AUTO_TEST_CASE( packed_file_test )
+{
+  const char *filename = "packed_file_test.ivp";
+  for (const auto &gd : { std::make_pair(&g_Borie, 20), std::make_pair(&S3, 200) }) {
+    const IVMPG::PermutationGroup<> &g = *gd.first;
+    const auto list = g.elements_of_depth(gd.second);
+    {
+      IVMPG::PackedWriter out(filename, g.fingerprint(), g.N, 1000);
+      out.set_depth(gd.second, gd.second);
+      for (const auto &v : list) out.push(v);
+    }
+    IVMPG::PackedReader in(filename);
+    BOOST_CHECK_EQUAL( in.header().fingerprint, g.fingerprint() );
+    BOOST_CHECK_EQUAL( in.header().N, g.N );
+    BOOST_CHECK_EQUAL( in.header().depth, uint64_t(gd.second) );
+    BOOST_REQUIRE_EQUAL( in.size(), list.size() );
+    BOOST_CHECK_EQUAL( in.nblocks(), (list.size() + 999) / 1000 );
+    BOOST_CHECK( std::equal(list.begin(), list.end(), in.begin()) );
+    BOOST_CHECK_EQUAL( std::distance(in.begin(), in.end()), list.size() );
+    uint64_t i = 0;
+    for (auto it = list.begin(); it != list.end(); it++, i += 7)
+      if (i % 1000 == 0 or i % 997 == 0) BOOST_CHECK_EQUAL( in[i / 7], *it );
+    // Smaller than with one byte per coordinate
+    BOOST_CHECK_LT( (uint64_t) std::ifstream(filename, std::ios::ate).tellg(),
+		    list.size() * g.N );
+  }
+  {
+    IVMPG::PackedWriter out(filename, 0, 3);
+  }
+  IVMPG::PackedReader empty(filename);
+  BOOST_CHECK_EQUAL( empty.size(), 0u );
+  BOOST_CHECK( empty.begin() == empty.end() );
+  std::remove(filename);
+  BOOST_CHECK_THROW( IVMPG::PackedReader("group16_test.cpp"), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( enumeration_cache_test )
+{
+  IVMPG::EnumerationCache cache("enumeration_cache_test.dir");
+  const auto list = g_Borie.elements_of_depth(15);
+  const IVMPG::Vect16 eval {8, 8};
+  const uint64_t neval = g_Borie.elements_of_evaluation_number(eval);
+  for (int pass = 0; pass < 2; pass++) {  // Computed then read from the cache
+    BOOST_CHECK_EQUAL( cache.elements_of_depth_number(g_Borie, 15, 2),
+		       g_Borie.elements_of_depth_number(15, 2) );
+    BOOST_CHECK_EQUAL( cache.elements_of_evaluation_number(g_Borie, eval), neval );
+    const IVMPG::PackedReader in = cache.elements_of_depth(g_Borie, 15, 15);
+    BOOST_CHECK_EQUAL( in.header().fingerprint, g_Borie.fingerprint() );
+    BOOST_REQUIRE_EQUAL( in.size(), list.size() );
+    BOOST_CHECK( std::equal(list.begin(), list.end(), in.begin()) );
+    BOOST_CHECK_EQUAL( cache.elements_of_evaluation(g_Borie, eval).size(), neval );
+  }
+  // Served by the listing, whatever the max_part from the depth on
+  BOOST_CHECK_EQUAL( cache.path(g_Borie, 15, 100), cache.path(g_Borie, 15, 15) );
+  BOOST_CHECK_EQUAL( cache.elements_of_depth_number(g_Borie, 15, 15), list.size() );
+  BOOST_CHECK_EQUAL( cache.elements_of_depth_number(g_Borie, 15, 100), list.size() );
+  // Truncated results are not stored
+  IVMPG::EnumerationControl ctl(10);
+  BOOST_CHECK_EQUAL( cache.elements_of_depth(g_Borie, 16, 16, &ctl).size(), 10u );
+  BOOST_CHECK( not std::ifstream(cache.path(g_Borie, 16, 16) + ".ivp") );
+
+  for (const char *ext : {".count", ".ivp"}) {
+    std::remove((cache.path(g_Borie, 15, 2) + ext).c_str());
+    std::remove((cache.path(g_Borie, 15, 15) + ext).c_str());
+    std::remove((cache.path(g_Borie, eval) + ext).c_str());
+  }
+  BOOST_CHECK_EQUAL( rmdir(cache.directory().c_str()), 0 );
+}
+
 #ifdef USE_CILK
 
 BOOST_AUTO_TEST_CASE( elements_of_depth_huge_test )
@@ -0,0 +1,32 @@
+#*****************************************************************************
+#       Copyright (C) 2014 Florent Hivert <Florent.Hivert@univ-rouen.fr>,
+#
+#  Distributed under the terms of the GNU General Public License (GPL)
+#
+#    This code is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#    General Public License for more details.
+#
+#  The full text of the GPL is available at:
+#
+#                  http://www.gnu.org/licenses/
+#*****************************************************************************
+
+cimport group16
+from libc.stdint cimport uint8_t
+from libcpp.vector cimport vector as stl_vector
+
+cdef class RowArray(object):
+    cdef stl_vector[uint8_t] _rows
+    cdef Py_ssize_t _shape[2]
+    cdef Py_ssize_t _strides[2]
+    cdef readonly bint truncated
+
+cdef RowArray make_row_array(stl_vector[uint8_t] &rows, size_t width, bint truncated)
+cdef canonical_array(group16.PermutationGroup16 *g, a, out)
+cdef is_canonical_array(group16.PermutationGroup16 *g, a, out)
+cdef void set_control(group16.EnumerationControl &ctl, max_results, timeout) except *
+
+cdef class PermGroup16(object):
+    cdef group16.PermutationGroup16 *_g
@@ -0,0 +1,438 @@
+r"""
+Python bindings of the enumeration engine which don't need Sage. The group
+is given by a strong generating system, each permutation being the list of
+the images of 0..N-1. The results are returned as contiguous arrays of
+bytes, one row of N coordinates per vector, exported through the buffer
+protocol so that ``memoryview`` or ``numpy.asarray`` use them without copy.
+
+EXAMPLES::
+
+    >>> import group16mod
+    >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+    ...                                       [[0,1,2], [0,2,1]]])
+    >>> res = S3.elements_of_depth_array(3)
+    >>> len(res), res.width
+    (3, 3)
+    >>> res.tolist()
+    [[3, 0, 0], [2, 1, 0], [1, 1, 1]]
+    >>> m = memoryview(res)
+    >>> m.shape, m.format, m.readonly
+    ((3, 3), 'B', True)
+    >>> m.tolist()[1]
+    [2, 1, 0]
+"""
+#*****************************************************************************
+#       Copyright (C) 2014 Florent Hivert <Florent.Hivert@univ-rouen.fr>,
+#
+#  Distributed under the terms of the GNU General Public License (GPL)
+#
+#    This code is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#    General Public License for more details.
+#
+#  The full text of the GPL is available at:
+#
+#                  http://www.gnu.org/licenses/
+#*****************************************************************************
+
+cimport cython
+from cpython.buffer cimport PyBUF_WRITABLE
+from libc.stdint cimport uint8_t, uint64_t
+from libcpp.vector cimport vector as stl_vector
+from libcpp.string cimport string as stl_string
+
+cimport group16
+
+cdef uint8_t empty_row[1]
+
+cdef class RowArray(object):
+    r"""
+    Read only array of rows of bytes, exported through the buffer protocol.
+
+    EXAMPLES::
+
+        >>> import group16mod
+        >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+        ...                                       [[0,1,2], [0,2,1]]])
+        >>> res = S3.elements_of_depth_array(0)
+        >>> len(res), res.tolist(), res.truncated
+        (1, [[0, 0, 0]], False)
+    """
+    def __init__(self):
+        raise RuntimeError("C++ interface class ! You cannot build a RowArray from Python")
+
+    def __len__(self):
+        return self._shape[0]
+
+    property width:
+        def __get__(self):
+            return self._shape[1]
+
+    def tolist(self):
+        cdef Py_ssize_t i, w = self._shape[1]
+        return [[self._rows[i*w + j] for j in range(w)] for i in range(self._shape[0])]
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+        if flags & PyBUF_WRITABLE:
+            raise BufferError("RowArray is read only")
+        buffer.buf = self._rows.data() if self._rows.size() else empty_row
+        buffer.format = 'B'
+        buffer.internal = NULL
+        buffer.itemsize = 1
+        buffer.len = self._rows.size()
+        buffer.ndim = 2
+        buffer.obj = self
+        buffer.readonly = 1
+        buffer.shape = self._shape
+        buffer.strides = self._strides
+        buffer.suboffsets = NULL
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        pass
+
+cdef RowArray make_row_array(stl_vector[uint8_t] &rows, size_t width, bint truncated):
+    r"""
+    Build a RowArray taking the content of rows, which is left empty.
+    """
+    cdef RowArray res = RowArray.__new__(RowArray)
+    res._rows.swap(rows)
+    res._shape[0] = res._rows.size() // width if width else 0
+    res._shape[1] = width
+    res._strides[0] = width
+    res._strides[1] = 1
+    res.truncated = truncated
+    return res
+
+cdef void set_control(group16.EnumerationControl &ctl, max_results, timeout) except *:
+    if max_results is not None:
+        ctl.max_results = max_results
+    if timeout is not None:
+        ctl.set_timeout_seconds(timeout)
+
+cdef check_rows(const uint8_t[:, :] rows, size_t N):
+    if rows.shape[1] != N:
+        raise ValueError("Expected rows of %s coordinates"%N)
+    if rows.strides[1] != 1 or rows.strides[0] < 0:
+        raise ValueError("The rows should be contiguous and in increasing order")
+
+@cython.boundscheck(False)
+cdef canonical_array(group16.PermutationGroup16 *g, a, out):
+    r"""
+    The canonical forms of the rows of the (n x N) array of bytes ``a``,
+    stored in ``out`` or in a new ``numpy`` array, which is returned.
+    """
+    cdef const uint8_t[:, :] rows = a
+    cdef uint8_t[:, ::1] res
+    cdef size_t n = rows.shape[0]
+    check_rows(rows, g.N)
+    if out is None:
+        import numpy
+        out = numpy.empty((n, g.N), dtype=numpy.uint8)
+    res = out
+    if res.shape[0] != n or res.shape[1] != g.N:
+        raise ValueError("The result should be of shape (%s, %s)"%(n, g.N))
+    if n:
+        with nogil:
+            g.canonical_rows(&rows[0, 0], n, rows.strides[0], &res[0, 0])
+    return out
+
+@cython.boundscheck(False)
+cdef is_canonical_array(group16.PermutationGroup16 *g, a, out):
+    r"""
+    Whether the rows of the (n x N) array of bytes ``a`` are canonical,
+    stored in ``out`` or in a new ``numpy`` array of booleans, which is
+    returned.
+    """
+    cdef const uint8_t[:, :] rows = a
+    cdef uint8_t[::1] res
+    cdef size_t n = rows.shape[0]
+    check_rows(rows, g.N)
+    if out is None:
+        import numpy
+        out = numpy.empty(n, dtype=bool)
+    res = out.view('u1') if getattr(out, 'dtype', None) == bool else out
+    if res.shape[0] != n:
+        raise ValueError("The result should be of length %s"%n)
+    if n:
+        with nogil:
+            g.is_canonical_rows(&rows[0, 0], n, rows.strides[0], &res[0])
+    return out
+
+cdef group16.Vect16 to_vect16(l, size_t N) except *:
+    cdef group16.Vect16 res
+    cdef size_t i
+    if len(l) > N:
+        raise ValueError("Expected at most %s coordinates"%N)
+    for i in range(16):
+        res[i] = 0
+    for i in range(len(l)):
+        if not 0 <= l[i] < 256:
+            raise ValueError("Coordinates should be in range(256)")
+        res[i] = l[i]
+    return res
+
+
+cdef class ChunkState(object):
+    r"""
+    Internal state of the chunked enumerations.
+    """
+    cdef object callback
+    cdef size_t width
+    cdef object error
+    cdef group16.EnumerationControl *ctl
+
+cdef void chunk_sink(void *context, stl_vector[uint8_t] &rows) noexcept with gil:
+    cdef ChunkState state = <ChunkState> context
+    if state.error is not None:
+        return
+    try:
+        state.callback(make_row_array(rows, state.width, False))
+    except BaseException as e:
+        state.error = e
+        state.ctl.cancel()
+
+
+cdef class PermGroup16(object):
+    r"""
+    A permutation group acting on at most 16 points.
+
+    INPUT:
+
+    - ``name`` -- a string
+    - ``N`` -- the number of points
+    - ``sgs`` -- a strong generating system: the list of the transversals of
+      the stabilizer chain of 0, 1, ... Each transversal is a list of
+      permutations, given by the lists of their images, starting with the
+      identity. The trailing trivial transversals may be omitted.
+    """
+    def __cinit__(self, name, size_t N, sgs):
+        cdef stl_vector[stl_vector[group16.Perm16]] csgs
+        cdef stl_vector[group16.Perm16] lev
+        cdef group16.Perm16 p16
+        cdef size_t i
+        if N > 16:
+            raise ValueError("At most 16 points")
+        for level in sgs:
+            lev.clear()
+            for per in level:
+                if sorted(per) != list(range(N)):
+                    raise ValueError("%s is not a permutation of range(%s)"%(per, N))
+                for i in range(N):
+                    p16[i] = per[i]
+                lev.push_back(p16)
+            csgs.push_back(lev)
+        for i in range(N):
+            p16[i] = i
+        lev.clear()
+        lev.push_back(p16)
+        while csgs.size() + 1 < N:
+            csgs.push_back(lev)
+        self._g = new group16.PermutationGroup16(name.encode(), N, csgs)
+        if not self._g.check_sgs():
+            del self._g
+            self._g = NULL
+            raise ValueError("Incorrect strong generating system")
+
+    def __dealloc__(self):
+        if self._g != NULL:
+            del self._g
+
+    property N:
+        def __get__(self):
+            return self._g.N
+
+    def is_canonical(self, v):
+        r"""
+        EXAMPLES::
+
+            >>> import group16mod
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> S3.is_canonical([2,1,0]), S3.is_canonical([1,2,0])
+            (True, False)
+        """
+        return self._g.is_canonical(to_vect16(v, self._g.N))
+
+    def canonical(self, v):
+        r"""
+        EXAMPLES::
+
+            >>> import group16mod
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> S3.canonical([1,2,0])
+            [2, 1, 0]
+        """
+        cdef group16.Vect16 res = self._g.canonical(to_vect16(v, self._g.N))
+        return [res[i] for i in range(self._g.N)]
+
+    def canonical_array(self, a, out=None):
+        r"""
+        The canonical forms of the rows of the (n x N) array of bytes ``a``,
+        for instance a ``numpy`` array of ``uint8``, stored in ``out`` or in
+        a new ``numpy`` array. The rows are shared among the workers with the
+        GIL released.
+
+        EXAMPLES::
+
+            >>> import group16mod, numpy
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> a = numpy.array([[1,2,0], [0,0,5], [3,1,1]], dtype=numpy.uint8)
+            >>> S3.canonical_array(a).tolist()
+            [[2, 1, 0], [5, 0, 0], [3, 1, 1]]
+            >>> out = numpy.zeros((2, 3), dtype=numpy.uint8)
+            >>> S3.canonical_array(a[::2], out) is out, out.tolist()
+            (True, [[2, 1, 0], [3, 1, 1]])
+            >>> S3.canonical_array(a[:, :2])
+            Traceback (most recent call last):
+            ...
+            ValueError: Expected rows of 3 coordinates
+        """
+        return canonical_array(self._g, a, out)
+
+    def is_canonical_array(self, a, out=None):
+        r"""
+        Whether the rows of the (n x N) array of bytes ``a`` are canonical, as
+        a ``numpy`` array of booleans or in ``out``. See :meth:`canonical_array`.
+
+        EXAMPLES::
+
+            >>> import group16mod, numpy
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> a = numpy.array([[1,2,0], [0,0,5], [3,1,1]], dtype=numpy.uint8)
+            >>> S3.is_canonical_array(a).tolist()
+            [False, False, True]
+            >>> res = S3.elements_of_depth_array(10)
+            >>> bool(S3.is_canonical_array(res).all())
+            True
+        """
+        return is_canonical_array(self._g, a, out)
+
+    def sort_transversals(self, uint64_t depth, max_part=None):
+        r"""
+        Reorder the strong generating set so that the canonical tests of the
+        vectors of sum up to ``depth`` with coordinates at most ``max_part``
+        reject their non canonical vectors sooner. The results of the group
+        are unchanged, only their speed. The GIL is released meanwhile.
+
+        EXAMPLES::
+
+            >>> import group16mod
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> res = S3.elements_of_depth_array(10).tolist()
+            >>> S3.sort_transversals(10)
+            >>> S3.elements_of_depth_array(10).tolist() == res
+            True
+        """
+        cdef uint64_t mp = depth if max_part is None else max_part
+        with nogil:
+            self._g.sort_transversals(depth, mp)
+
+    def elements_of_depth_array(self, uint64_t depth, max_part=None,
+                                max_results=None, timeout=None):
+        r"""
+        The canonical vectors of sum ``depth`` with coordinates at most
+        ``max_part``, as a :class:`RowArray`. The enumeration stops after
+        ``max_results`` results or ``timeout`` seconds, the result being then
+        marked as ``truncated``. The GIL is released during the enumeration.
+
+        EXAMPLES::
+
+            >>> import group16mod
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> S3.elements_of_depth_array(4, max_part=2).tolist()
+            [[2, 2, 0], [2, 1, 1]]
+            >>> res = S3.elements_of_depth_array(20, max_results=10)
+            >>> len(res), res.truncated
+            (10, True)
+        """
+        cdef group16.EnumerationControl ctl
+        cdef uint64_t mp = depth if max_part is None else max_part
+        cdef group16.RowCollector16 *rows = new group16.RowCollector16(self._g.N)
+        try:
+            set_control(ctl, max_results, timeout)
+            with nogil:
+                self._g.elements_of_depth_rows(depth, mp, rows[0], &ctl)
+            return make_row_array(rows.buffer(), self._g.N, ctl.truncated())
+        finally:
+            del rows
+
+    def elements_of_evaluation_array(self, evaluation, max_results=None, timeout=None):
+        r"""
+        The canonical vectors having ``evaluation[i]`` coordinates equal to
+        ``i``, as a :class:`RowArray`. See :meth:`elements_of_depth_array`.
+
+        EXAMPLES::
+
+            >>> import group16mod
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> S3.elements_of_evaluation_array([1,1,1]).tolist()
+            [[2, 1, 0]]
+            >>> S3.elements_of_evaluation_array([1,1,0])
+            Traceback (most recent call last):
+            ...
+            ValueError: Evaluation should be of sum 3
+        """
+        cdef group16.EnumerationControl ctl
+        cdef group16.Vect16 ev = to_vect16(evaluation, self._g.N)
+        cdef group16.RowCollector16 *rows
+        if sum(evaluation) != self._g.N:
+            raise ValueError("Evaluation should be of sum %s"%self._g.N)
+        rows = new group16.RowCollector16(self._g.N)
+        try:
+            set_control(ctl, max_results, timeout)
+            with nogil:
+                self._g.elements_of_evaluation_rows(ev, rows[0], &ctl)
+            return make_row_array(rows.buffer(), self._g.N, ctl.truncated())
+        finally:
+            del rows
+
+    def elements_of_depth_chunks(self, uint64_t depth, callback, size_t chunk_rows=1 << 16,
+                                 max_part=None, max_results=None, timeout=None):
+        r"""
+        Same as :meth:`elements_of_depth_array`, calling ``callback`` on
+        :class:`RowArray` chunks of at most ``chunk_rows`` rows during the
+        enumeration. Return the number of results and whether the
+        enumeration was truncated. An exception raised by ``callback`` stops
+        the enumeration and is raised again.
+
+        EXAMPLES::
+
+            >>> import group16mod
+            >>> S3 = group16mod.PermGroup16("S3", 3, [[[0,1,2], [1,0,2], [2,1,0]],
+            ...                                       [[0,1,2], [0,2,1]]])
+            >>> chunks = []
+            >>> S3.elements_of_depth_chunks(20, chunks.append, chunk_rows=10)
+            (44, False)
+            >>> [len(c) for c in chunks]
+            [10, 10, 10, 10, 4]
+            >>> def fail(chunk): raise KeyError("stop")
+            >>> S3.elements_of_depth_chunks(20, fail, chunk_rows=10)
+            Traceback (most recent call last):
+            ...
+            KeyError: 'stop'
+        """
+        cdef group16.EnumerationControl ctl
+        cdef uint64_t mp = depth if max_part is None else max_part
+        cdef uint64_t res
+        cdef ChunkState state = ChunkState.__new__(ChunkState)
+        cdef group16.RowCollector16 *rows
+        set_control(ctl, max_results, timeout)
+        state.callback = callback
+        state.width = self._g.N
+        state.ctl = &ctl
+        rows = new group16.RowCollector16(self._g.N, chunk_rows, chunk_sink, <void *> state)
+        try:
+            with nogil:
+                res = self._g.elements_of_depth_rows(depth, mp, rows[0], &ctl)
+        finally:
+            del rows
+        if state.error is not None:
+            raise state.error
+        return res, ctl.truncated()
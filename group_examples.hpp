@@ -22,7 +22,7 @@
 namespace IVMPG {
 
 template< class Group = PermutationGroup<> > struct GroupExamples {
-  static Group S3, g100, g_Borie;
+  static Group S3, S2xS4, g100, g_Borie, S7_edges;
 };
 
 
@@ -37,6 +37,20 @@ Group GroupExamples< Group >::S3("S3", 3, {
     {{0,1,2}}
   });;
 
+/* Direct product of S2 and S4 acting on 6 points
+************************************************
+G = direct_product_permgroups([SymmetricGroup(2), SymmetricGroup(4)])
+************************************************/
+template< class Group >
+Group GroupExamples< Group >::S2xS4("S2xS4", 6, {
+    {{0,1,2,3,4,5}, {1,0,2,3,4,5}},
+    {{0,1,2,3,4,5}},
+    {{0,1,2,3,4,5}, {0,1,3,2,4,5}, {0,1,4,3,2,5}, {0,1,5,3,4,2}},
+    {{0,1,2,3,4,5}, {0,1,2,4,3,5}, {0,1,2,5,4,3}},
+    {{0,1,2,3,4,5}, {0,1,2,3,5,4}},
+    {{0,1,2,3,4,5}}
+  });
+
 /* transitive subgroup of S6 number 100 according to Sage
 **********************************************************
 G = PermutationGroup([[(3,5),(4,6)], [(1,5),(2,6),(3,4)]])
@@ -127,6 +141,69 @@ Group GroupExamples< Group >::g_Borie("N. Borie's favorite", 16,
  {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}},
  {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}}} );
 
+/* Symmetric group S7 acting on the 21 edges of the complete graph K7
+   numbered in lexicographic order (0,1), (0,2), ..., (5,6). The orbits of
+   vectors are the multigraphs on 7 unlabeled vertices.
+*********************************************************************/
+template< class Group >
+Group GroupExamples< Group >::S7_edges("Edges of K7", 21,
+{{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20},
+  {1, 0, 5, 4, 2, 3, 6, 14, 13, 11, 12, 10, 9, 7, 8, 20, 17, 19, 16, 18, 15},
+  {2, 1, 3, 4, 5, 0, 11, 15, 16, 17, 7, 12, 13, 14, 6, 18, 19, 8, 20, 9, 10},
+  {3, 2, 4, 5, 0, 1, 15, 18, 19, 8, 12, 16, 17, 7, 11, 20, 9, 13, 10, 14, 6},
+  {4, 18, 16, 9, 13, 20, 3, 2, 0, 1, 5, 15, 8, 12, 19, 7, 11, 17, 6, 10, 14},
+  {5, 10, 14, 17, 19, 20, 0, 1, 2, 3, 4, 6, 7, 8, 9, 11, 12, 13, 15, 16, 18},
+  {6, 8, 10, 7, 0, 9, 12, 14, 11, 1, 13, 19, 15, 3, 18, 17, 5, 20, 2, 16, 4},
+  {7, 9, 10, 8, 6, 0, 16, 17, 15, 11, 2, 20, 18, 13, 4, 19, 14, 5, 12, 3, 1},
+  {8, 6, 10, 7, 0, 9, 12, 19, 15, 3, 18, 14, 11, 1, 13, 17, 5, 20, 2, 16, 4},
+  {9, 0, 7, 10, 8, 6, 4, 16, 20, 18, 13, 2, 5, 3, 1, 17, 15, 11, 19, 14, 12},
+  {10, 19, 14, 5, 20, 17, 8, 6, 0, 9, 7, 12, 3, 18, 15, 1, 13, 11, 4, 2, 16},
+  {11, 15, 2, 7, 16, 17, 12, 1, 6, 13, 14, 3, 8, 18, 19, 0, 4, 5, 9, 10, 20},
+  {12, 6, 13, 14, 1, 11, 8, 18, 19, 3, 15, 9, 10, 0, 7, 20, 4, 16, 5, 17, 2},
+  {13, 12, 11, 14, 6, 1, 18, 16, 20, 9, 4, 15, 19, 8, 3, 17, 7, 2, 10, 5, 0},
+  {14, 20, 5, 10, 17, 19, 13, 1, 6, 11, 12, 4, 9, 16, 18, 0, 2, 3, 7, 8, 15},
+  {15, 11, 2, 7, 16, 17, 12, 3, 8, 18, 19, 1, 6, 13, 14, 0, 4, 5, 9, 10, 20},
+  {16, 17, 7, 2, 15, 11, 20, 9, 4, 18, 13, 10, 5, 19, 14, 0, 8, 6, 3, 1, 12},
+  {17, 16, 7, 2, 15, 11, 20, 10, 5, 19, 14, 9, 4, 18, 13, 0, 8, 6, 3, 1, 12},
+  {18, 4, 9, 13, 20, 16, 3, 8, 12, 19, 15, 0, 1, 5, 2, 6, 10, 7, 14, 11, 17},
+  {19, 17, 10, 5, 20, 14, 15, 8, 3, 18, 12, 7, 2, 16, 11, 0, 9, 6, 4, 1, 13},
+  {20, 18, 4, 16, 9, 13, 19, 5, 17, 10, 14, 3, 15, 8, 12, 2, 0, 1, 7, 11, 6}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20},
+  {0, 2, 3, 4, 5, 1, 7, 8, 9, 10, 6, 15, 16, 17, 11, 18, 19, 12, 20, 13, 14},
+  {0, 3, 2, 1, 5, 4, 8, 7, 6, 10, 9, 15, 12, 19, 18, 11, 17, 16, 14, 13, 20},
+  {0, 4, 5, 2, 3, 1, 9, 10, 7, 8, 6, 20, 16, 18, 13, 17, 19, 14, 15, 11, 12},
+  {0, 5, 4, 2, 3, 1, 10, 9, 7, 8, 6, 20, 17, 19, 14, 16, 18, 13, 15, 11, 12},
+  {0, 6, 8, 7, 9, 10, 1, 3, 2, 4, 5, 12, 11, 13, 14, 15, 18, 19, 16, 17, 20},
+  {0, 7, 10, 8, 6, 9, 2, 5, 3, 1, 4, 17, 15, 11, 16, 19, 14, 20, 12, 18, 13},
+  {0, 8, 10, 7, 6, 9, 3, 5, 2, 1, 4, 19, 15, 12, 18, 17, 14, 20, 11, 16, 13},
+  {0, 9, 7, 10, 6, 8, 4, 2, 5, 1, 3, 16, 20, 13, 18, 17, 11, 15, 14, 19, 12},
+  {0, 10, 7, 9, 6, 8, 5, 2, 4, 1, 3, 17, 20, 14, 19, 16, 11, 15, 13, 18, 12}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20},
+  {0, 1, 3, 2, 5, 4, 6, 8, 7, 10, 9, 12, 11, 14, 13, 15, 19, 18, 17, 16, 20},
+  {0, 1, 4, 5, 2, 3, 6, 9, 10, 7, 8, 13, 14, 11, 12, 20, 16, 18, 17, 19, 15},
+  {0, 1, 5, 4, 2, 3, 6, 10, 9, 7, 8, 14, 13, 11, 12, 20, 17, 19, 16, 18, 15}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20},
+  {0, 1, 2, 4, 3, 5, 6, 7, 9, 8, 10, 11, 13, 12, 14, 16, 15, 17, 18, 20, 19},
+  {0, 1, 2, 5, 3, 4, 6, 7, 10, 8, 9, 11, 14, 12, 13, 17, 15, 16, 19, 20, 18}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20},
+  {0, 1, 2, 3, 5, 4, 6, 7, 8, 10, 9, 11, 12, 14, 13, 15, 17, 16, 19, 18, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}},
+ {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}}} );
+
 } //  namespace IVMPG
 
 #endif
@@ -0,0 +1,109 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+// Compiled once per instruction set level with the matching -m flags and
+// -DIVMPG_KERNEL_NS=<level>. Every kernel is flattened so that the inline
+// functions it uses (permuted, first_diff, the set probes...) are compiled
+// for the level inside of it, instead of being shared between the objects
+// where the linker could pick a copy using unsupported instructions. The
+// operations having an AVX2 or AVX512 version are defined in the namespace of
+// the level, so that each object has its own.
+
+#include "group_kernels.hpp"
+
+#ifndef IVMPG_KERNEL_NS
+#error "IVMPG_KERNEL_NS must be defined to the instruction set level"
+#endif
+
+namespace IVMPG {
+namespace Kernels {
+namespace IVMPG_KERNEL_NS {
+
+__attribute__((flatten))
+bool is_canonical(const PermutationGroup<Perm16> &g, Vect16 v,
+		  PermutationGroup<Perm16>::TemporaryStorage &st) {
+  return g.is_canonical_kernel(v, st);
+}
+#ifdef __AVX2__
+
+struct Ops32 {
+  static __m256i load(const Vect32 &v) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v.p.data()));
+  }
+  static uint64_t diff_mask(const Vect32 &a, const Vect32 &b) {
+    return ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load(a), load(b))));
+  }
+  static uint64_t lt_mask(const Vect32 &a, const Vect32 &b) {
+    const __m256i x = load(a);
+    return ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(x, load(b)), x)));
+  }
+  // vpshufb only shuffles inside each 128 bits lane: both lanes are
+  // broadcasted and the bit 4 of the index selects the right one.
+  static Vect32 permuted(const Vect32 &v, const Perm32 &p) {
+    const __m256i x = load(v), idx = load(p);
+    const __m256i lo = _mm256_permute2x128_si256(x, x, 0x00);
+    const __m256i hi = _mm256_permute2x128_si256(x, x, 0x11);
+    Vect32 res;
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(res.p.data()),
+			_mm256_blendv_epi8(_mm256_shuffle_epi8(lo, idx),
+					   _mm256_shuffle_epi8(hi, idx),
+					   _mm256_slli_epi16(idx, 3)));
+    return res;
+  }
+};
+
+#else
+using Ops32 = PermutationGroup<Perm32>::VectOps;
+#endif // __AVX2__
+
+#if defined(__AVX512BW__) and defined(__AVX512VBMI__)
+
+struct Ops64 {
+  static uint64_t diff_mask(const Vect64 &a, const Vect64 &b) {
+    return _mm512_cmpneq_epu8_mask(_mm512_loadu_si512(a.p.data()),
+				   _mm512_loadu_si512(b.p.data()));
+  }
+  static uint64_t lt_mask(const Vect64 &a, const Vect64 &b) {
+    return _mm512_cmplt_epu8_mask(_mm512_loadu_si512(a.p.data()),
+				  _mm512_loadu_si512(b.p.data()));
+  }
+  static Vect64 permuted(const Vect64 &v, const Perm64 &p) {
+    Vect64 res;
+    _mm512_storeu_si512(res.p.data(),
+			_mm512_maskz_permutexvar_epi8(~uint64_t(0),
+						      _mm512_loadu_si512(p.p.data()),
+						      _mm512_loadu_si512(v.p.data())));
+    return res;
+  }
+};
+
+#else
+using Ops64 = PermutationGroup<Perm64>::VectOps;
+#endif // __AVX512BW__ and __AVX512VBMI__
+
+__attribute__((flatten))
+bool is_canonical(const PermutationGroup<Perm32> &g, Vect32 v,
+		  PermutationGroup<Perm32>::TemporaryStorage &st) {
+  return g.is_canonical_mask<Ops32>(v, st);
+}
+__attribute__((flatten))
+bool is_canonical(const PermutationGroup<Perm64> &g, Vect64 v,
+		  PermutationGroup<Perm64>::TemporaryStorage &st) {
+  return g.is_canonical_mask<Ops64>(v, st);
+}
+
+} // namespace IVMPG_KERNEL_NS
+} // namespace Kernels
+} // namespace IVMPG
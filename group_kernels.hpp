@@ -0,0 +1,47 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _GROUP_KERNELS_HPP
+#define _GROUP_KERNELS_HPP
+
+#include "group.hpp"
+
+namespace IVMPG {
+namespace Kernels {
+
+// group_kernels.cpp is compiled once per instruction set level, defining
+// these functions in the namespace named after the level.
+#define IVMPG_DECLARE_KERNELS							\
+  bool is_canonical(const PermutationGroup<Perm16> &g, Vect16 v,		\
+		    PermutationGroup<Perm16>::TemporaryStorage &st);	\
+  bool is_canonical(const PermutationGroup<Perm32> &g, Vect32 v,		\
+		    PermutationGroup<Perm32>::TemporaryStorage &st);	\
+  bool is_canonical(const PermutationGroup<Perm64> &g, Vect64 v,		\
+		    PermutationGroup<Perm64>::TemporaryStorage &st);
+
+namespace sse4_2 { IVMPG_DECLARE_KERNELS }
+#ifdef HAVE_AVX2_KERNELS
+namespace avx2 { IVMPG_DECLARE_KERNELS }
+#endif
+#ifdef HAVE_AVX512_KERNELS
+namespace avx512 { IVMPG_DECLARE_KERNELS }
+#endif
+
+#undef IVMPG_DECLARE_KERNELS
+
+} // namespace Kernels
+} // namespace IVMPG
+
+#endif
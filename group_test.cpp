@@ -32,7 +32,11 @@
 
 //____________________________________________________________________________//
 
+#include <sstream>
+
 #include "perm16.hpp"
+#include "perm16w.hpp"
+#include "perm_simd.hpp"
 #include "perm_generic.hpp"
 #include "group_examples.hpp"
 
@@ -44,6 +48,7 @@ struct Fixture {
   using GroupType = IVMPG::PermutationGroup<PermType>;
   using VectType = typename PermType::vect;
   const GroupType &S3 = IVMPG::GroupExamples<GroupType>::S3;
+  const GroupType &S2xS4 = IVMPG::GroupExamples<GroupType>::S2xS4;
   const GroupType &g100  = IVMPG::GroupExamples<GroupType>::g100;
   const GroupType &g_Borie  = IVMPG::GroupExamples<GroupType>::g_Borie;
 
@@ -56,10 +61,28 @@ struct Fixture {
 
 typedef boost::mpl::list<
   Fixture< IVMPG::Perm16 >,
+  Fixture< IVMPG::Perm16w >,
+  Fixture< IVMPG::Perm32 >,
+  Fixture< IVMPG::Perm64 >,
   Fixture< IVMPG::PermGeneric<16> >,
   Fixture< IVMPG::PermGeneric<32> >
 > Fixtures;
 
+// Groups acting on more than 16 points
+template <class PermType>
+struct LargeFixture : public Fixture<PermType> {
+
+  using GroupType = typename Fixture<PermType>::GroupType;
+  const GroupType &S7_edges = IVMPG::GroupExamples<GroupType>::S7_edges;
+
+};
+
+typedef boost::mpl::list<
+  LargeFixture< IVMPG::Perm32 >,
+  LargeFixture< IVMPG::Perm64 >,
+  LargeFixture< IVMPG::PermGeneric<32> >
+> LargeFixtures;
+
 //____________________________________________________________________________//
 
 BOOST_AUTO_TEST_SUITE( group16_test )
@@ -68,10 +91,55 @@ BOOST_AUTO_TEST_SUITE( group16_test )
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( check_sgs_test, F, Fixtures, F )
 {
   BOOST_CHECK(F::S3.check_sgs());
+  BOOST_CHECK(F::S2xS4.check_sgs());
   BOOST_CHECK(F::g100.check_sgs());
   BOOST_CHECK(F::g_Borie.check_sgs());
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( from_generators_test, F, Fixtures, F )
+{
+  using G = typename F::GroupType;
+  using P = typename G::StrongGeneratingSet::value_type::value_type;
+  const auto order = [](const G &g) {
+    uint64_t res = 1;
+    for (const auto &transversal : g.sgs) res *= transversal.size();
+    return res;
+  };
+  std::vector<P> gens;
+  for (const auto &transversal : F::g_Borie.sgs)
+    gens.insert(gens.end(), transversal.begin(), transversal.end());
+  const G g = G::from_generators("Borie", 16, gens);
+  BOOST_CHECK( g.check_sgs() );
+  BOOST_CHECK_EQUAL( order(g), order(F::g_Borie) );
+  BOOST_CHECK_EQUAL( g.sym_tail, F::g_Borie.sym_tail );
+  BOOST_CHECK_EQUAL( g.fingerprint(), F::g_Borie.fingerprint() );
+  // Other representatives of the cosets of the stabilizers
+  auto sgs = F::g_Borie.sgs;
+  for (uint64_t i = 0; i + 1 < sgs.size(); i++)
+    for (size_t j = 1; j < sgs[i].size(); j++) sgs[i][j] = sgs[i][j] * sgs[i+1].back();
+  BOOST_CHECK( sgs != F::g_Borie.sgs );
+  BOOST_CHECK_EQUAL( G("Borie", 16, sgs).fingerprint(), F::g_Borie.fingerprint() );
+  BOOST_CHECK_NE( g.fingerprint(), F::S2xS4.fingerprint() );
+  for (uint64_t depth = 0; depth < 8; depth++)
+    BOOST_CHECK_EQUAL( g.elements_of_depth_number(depth),
+		       F::g_Borie.elements_of_depth_number(depth) );
+
+  const G h = G::from_generators("S2xS4", 6, {P({1,0}), P({0,1,3,2}), P({0,1,3,4,5,2})});
+  BOOST_CHECK( h.check_sgs() );
+  BOOST_CHECK_EQUAL( order(h), 48u );
+  BOOST_CHECK_EQUAL( h.sym_tail, 2u );
+  BOOST_CHECK_EQUAL( h.elements_of_depth_number(10), F::S2xS4.elements_of_depth_number(10) );
+  BOOST_CHECK_EQUAL( order(G::from_generators("trivial", 4, {})), 1u );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( symmetric_tail_test, F, Fixtures, F )
+{
+  BOOST_CHECK_EQUAL(F::S3.sym_tail, 0u);
+  BOOST_CHECK_EQUAL(F::S2xS4.sym_tail, 2u);
+  BOOST_CHECK_EQUAL(F::g100.sym_tail, 5u);
+  BOOST_CHECK_EQUAL(F::g_Borie.sym_tail, 15u);
+}
+
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( is_canonical_test, F, Fixtures, F )
 {
   using V = typename F::VectType;
@@ -80,6 +148,9 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( is_canonical_test, F, Fixtures, F )
   BOOST_CHECK_PREDICATE( F::is_not_canon, (F::S3)(V({0,1})) );
   BOOST_CHECK_PREDICATE( F::is_not_canon, (F::S3)(V({4,1,3})) );
   BOOST_CHECK_PREDICATE( F::is_canon, (F::S3)(V({4,3,3})) );
+  BOOST_CHECK_PREDICATE( F::is_canon, (F::S2xS4)(V({2,1,3,3,1})) );
+  BOOST_CHECK_PREDICATE( F::is_not_canon, (F::S2xS4)(V({1,2,3,3,1})) );
+  BOOST_CHECK_PREDICATE( F::is_not_canon, (F::S2xS4)(V({2,1,3,1,3})) );
 }
 
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( canonical_test, F, Fixtures, F )
@@ -90,6 +161,8 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( canonical_test, F, Fixtures, F )
   BOOST_CHECK_EQUAL( F::S3.canonical(V({0,1})),   V({1,0}) );
   BOOST_CHECK_EQUAL( F::S3.canonical(V({4,1,3})), V({4,3,1}) );
   BOOST_CHECK_EQUAL( F::S3.canonical(V({4,3,3})), V({4,3,3}) );
+  BOOST_CHECK_EQUAL( F::S2xS4.canonical(V({1,2,0,3,1,3})), V({2,1,3,3,1,0}) );
+  BOOST_CHECK_EQUAL( F::S2xS4.canonical(V({2,1,3,3,1})),   V({2,1,3,3,1}) );
 }
 
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_depth_test, F, Fixtures, F )
@@ -99,6 +172,11 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_depth_test, F, Fixtures, F )
   BOOST_CHECK_EQUAL( F::S3.elements_of_depth(10).size(), 14u ); // Checked with Sage
   BOOST_CHECK_EQUAL( F::S3.elements_of_depth(20).size(), 44u ); // Checked with Sage
 
+  BOOST_CHECK_EQUAL( F::S2xS4.elements_of_depth( 0).size(),    1u );
+  BOOST_CHECK_EQUAL( F::S2xS4.elements_of_depth( 5).size(),   27u ); // Checked with Sage
+  BOOST_CHECK_EQUAL( F::S2xS4.elements_of_depth(10).size(),  191u ); // Checked with Sage
+  BOOST_CHECK_EQUAL( F::S2xS4.elements_of_depth(20).size(), 2178u ); // Checked with Sage
+
   BOOST_CHECK_EQUAL( F::g100.elements_of_depth( 0).size(),    1u );
   BOOST_CHECK_EQUAL( F::g100.elements_of_depth( 5).size(),   26u ); // Checked with Sage
   BOOST_CHECK_EQUAL( F::g100.elements_of_depth(10).size(),  280u ); // Checked with Sage
@@ -122,6 +200,15 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_depth_max_part_test, F, Fixtures,
     for (size_t i=0; i<S3_sz[max].size(); i++)
       BOOST_CHECK_EQUAL( F::S3.elements_of_depth(i, max).size(), S3_sz[max][i] );
 
+  std::vector< std::vector<size_t> > S2xS4_sz { // Checked with Sage
+    {1, 0},
+    {1, 2, 3, 3, 3, 2, 1, 0},
+    {1, 2, 5, 7, 11, 12, 14, 12, 11, 7, 5, 2, 1, 0},
+    {1, 2, 5, 9, 15, 21, 29, 34, 39, 40, 39, 34, 29, 21, 15, 9, 5, 2, 1, 0} };
+  for (size_t max = 0; max < S2xS4_sz.size(); max++)
+    for (size_t i=0; i<S2xS4_sz[max].size(); i++)
+      BOOST_CHECK_EQUAL( F::S2xS4.elements_of_depth(i, max).size(), S2xS4_sz[max][i] );
+
   std::vector< std::vector<size_t> > g100_sz { // Checked with Sage
     {1, 0},
     {1, 1, 3, 3, 3, 1, 1, 0},
@@ -143,4 +230,478 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_depth_max_part_test, F, Fixtures,
       BOOST_CHECK_EQUAL( F::g_Borie.elements_of_depth(i, max).size(), g_Borie_sz[max][i] );
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_evaluation_test, F, Fixtures, F )
+{
+  using V = typename F::VectType;
+  auto res = F::S3.elements_of_evaluation(V({1,1,1}));
+  BOOST_CHECK_EQUAL( res.size(), 1u );
+  BOOST_CHECK_EQUAL( res.front(), V({2,1,0}) );
+  // The first 2 coordinates hold 0, 1 or 2 of the ones
+  res = F::S2xS4.elements_of_evaluation(V({3,3}));
+  BOOST_CHECK_EQUAL( res.size(), 3u );
+  BOOST_CHECK_EQUAL( res.front(), V({1,1,1,0,0,0}) );
+  BOOST_CHECK_EQUAL( res.back(), V({0,0,1,1,1,0}) );
+  BOOST_CHECK_EQUAL( F::S2xS4.elements_of_evaluation_number(V({2,2,2})), 6u );
+  BOOST_CHECK_EQUAL( F::g100.elements_of_evaluation_number(V({2,2,2})), 11u );
+  BOOST_CHECK_EQUAL( F::g_Borie.elements_of_evaluation_number(V({3,13})), 3u );
+  BOOST_CHECK_EQUAL( F::g_Borie.elements_of_evaluation_number(V({4,4,4,4})), 466u );
+  for (auto v : F::g_Borie.elements_of_evaluation(V({4,4,4,4})))
+    BOOST_CHECK( F::g_Borie.is_canonical(v) );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( orbits_test, F, Fixtures, F )
+{
+  using vec = std::vector<uint64_t>;
+  BOOST_CHECK( F::S2xS4.orbits() == vec({0,0,2,2,2,2}) );
+  BOOST_CHECK( F::g_Borie.orbits() == vec(16, 0) );
+  BOOST_CHECK( F::S2xS4.is_invariant({1,1,3,3,3,3}) );
+  BOOST_CHECK( not F::S2xS4.is_invariant({1,1,3,3,3,2}) );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_degree_test, F, Fixtures, F )
+{
+  using Constraints = typename F::GroupType::Constraints;
+  const auto &g = F::S2xS4;
+  // Without constraints, same as elements_of_depth
+  for (uint64_t d : {0, 5, 10})
+    BOOST_CHECK( g.elements_of_degree(d, {}) == g.elements_of_depth(d) );
+
+  // Compare with the filtered listings
+  const std::vector<uint64_t> bound {1,1,3,3,3,3}, weight {2,2,1,1,1,1};
+  auto support2 = [](const typename F::VectType &v) {
+    size_t nz = 0;
+    for (size_t i=0; i<6; i++) nz += v[i] != 0;
+    return nz <= 2;
+  };
+  for (uint64_t d=0; d<10; d++) {
+    uint64_t bounded = 0, weighted = 0, pred = 0;
+    for (uint64_t depth=0; depth<=d; depth++)
+      for (auto v : g.elements_of_depth(depth)) {
+	uint64_t wd = 0;
+	bool in_bound = true;
+	for (size_t i=0; i<6; i++) { wd += weight[i]*v[i]; in_bound &= v[i] <= bound[i]; }
+	if (depth == d and in_bound) bounded++;
+	if (wd == d) weighted++;
+	if (depth == d and support2(v)) pred++;
+      }
+    BOOST_CHECK_EQUAL( g.elements_of_degree_number(d, Constraints {bound, {}, {}}), bounded );
+    BOOST_CHECK_EQUAL( g.elements_of_degree_number(d, Constraints {{}, weight, {}}), weighted );
+    BOOST_CHECK_EQUAL( g.elements_of_degree_number(d, Constraints {{}, {}, support2}), pred );
+  }
+  // [0,0,3,0,0,0], [0,0,2,1,0,0] and [1,0,1,0,0,0]
+  BOOST_CHECK_EQUAL( g.elements_of_degree_number(3, Constraints {bound, weight, support2}), 3u );
+
+  // Invalid constraints
+  BOOST_CHECK_THROW( g.elements_of_degree_number(3, Constraints {{1,1,3}, {}, {}}),
+		     std::invalid_argument );
+  BOOST_CHECK_THROW( g.elements_of_degree(3, Constraints {{}, {2,2,1,1,1}, {}}),
+		     std::invalid_argument );
+  BOOST_CHECK_THROW( g.elements_of_degree_number(3, Constraints {{1,3,3,3,3,3}, {}, {}}),
+		     std::invalid_argument );
+  BOOST_CHECK_THROW( g.elements_of_degree_number(3, Constraints {{}, {0,0,1,1,1,1}, {}}),
+		     std::invalid_argument );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( enumeration_control_test, F, Fixtures, F )
+{
+  using V = typename F::VectType;
+  using IVMPG::EnumerationControl;
+  {
+    EnumerationControl ctl(100);
+    auto res = F::g_Borie.elements_of_depth(20, &ctl);
+    BOOST_CHECK_EQUAL( res.size(), 100u );
+    BOOST_CHECK_EQUAL( ctl.results(), 100u );
+    BOOST_CHECK( ctl.truncated() );
+    // Same prefix as the full enumeration
+    auto full = F::g_Borie.elements_of_depth(20);
+    BOOST_CHECK( std::equal(res.begin(), res.end(), full.begin()) );
+  }
+  {
+    EnumerationControl ctl(545);
+    BOOST_CHECK_EQUAL( F::g_Borie.elements_of_depth_number(10, &ctl), 545u );
+    BOOST_CHECK( not ctl.truncated() );
+  }
+  {
+    EnumerationControl ctl(std::chrono::seconds(0));
+    BOOST_CHECK_EQUAL( F::g_Borie.elements_of_depth_number(10, &ctl), 0u );
+    BOOST_CHECK( ctl.truncated() );
+  }
+  {
+    EnumerationControl ctl;
+    ctl.cancel();
+    BOOST_CHECK( F::S3.elements_of_evaluation(V({1,1,1}), &ctl).empty() );
+  }
+  {
+    // Cancelled during the walk
+    EnumerationControl ctl;
+    uint64_t calls = 0;
+    typename F::GroupType::Constraints cons;
+    cons.predicate = [&](const V &) { if (++calls == 1000) ctl.cancel(); return true; };
+    const uint64_t res = F::g_Borie.elements_of_degree_number(20, cons, &ctl);
+    BOOST_CHECK( ctl.truncated() );
+    BOOST_CHECK_LT( res, 57605u );
+    BOOST_CHECK_LT( calls, 1100u );
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_depth_rows_test, F, Fixtures, F )
+{
+  using G = typename F::GroupType;
+  const G &g = F::g_Borie;
+  const auto list = g.elements_of_depth(10);
+  typename G::RowCollector rows(g.N);
+  BOOST_CHECK_EQUAL( g.elements_of_depth_rows(10, 10, rows), list.size() );
+  const auto &buf = rows.buffer();
+  BOOST_REQUIRE_EQUAL( buf.size(), list.size() * g.N );
+  size_t i = 0;
+  for (const auto &v : list)
+    for (size_t j = 0; j < g.N; j++, i++) BOOST_CHECK_EQUAL( buf[i], v[j] );
+
+  // By chunks of 100 rows
+  std::vector<size_t> chunks;
+  auto sink = [](void *ctx, typename G::RowCollector::chunk &c) {
+    static_cast<std::vector<size_t> *>(ctx)->push_back(c.size()); };
+  typename G::RowCollector chunked(g.N, 100, sink, &chunks);
+  BOOST_CHECK_EQUAL( g.elements_of_depth_rows(10, 10, chunked), 545u );
+  BOOST_CHECK( chunked.buffer().empty() );
+  BOOST_CHECK_EQUAL( chunks.size(), 6u );
+  BOOST_CHECK_EQUAL( chunks[0], 100 * g.N );
+  BOOST_CHECK_EQUAL( chunks[5], 45 * g.N );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_depth_tree_test, F, Fixtures, F )
+{
+  for (uint64_t depth : {0, 1, 2, 10}) {
+    const auto list = F::g_Borie.elements_of_depth(depth);
+    const auto tree = F::g_Borie.elements_of_depth_tree(depth, depth);
+    BOOST_CHECK( not tree.truncated );
+    BOOST_CHECK_EQUAL( tree.size(), list.size() );
+    BOOST_CHECK_EQUAL( std::distance(tree.begin(), tree.end()), list.size() );
+    BOOST_CHECK( std::equal(list.begin(), list.end(), tree.begin()) );
+  }
+  // Less than one bit per coordinate
+  const auto tree10 = F::g_Borie.elements_of_depth_tree(10, 10);
+  BOOST_CHECK_LT( tree10.bits.size(), tree10.size() * F::g_Borie.N );
+  const auto list = F::S2xS4.elements_of_depth(20, 4);
+  auto tree = F::S2xS4.elements_of_depth_tree(20, 4);
+  BOOST_CHECK_EQUAL( tree.size(), list.size() );
+  BOOST_CHECK( std::equal(list.begin(), list.end(), tree.begin()) );
+
+  std::stringstream file;
+  tree.save(file);
+  decltype(tree) loaded;
+  loaded.load(file);
+  BOOST_CHECK_EQUAL( loaded.size(), list.size() );
+  BOOST_CHECK( std::equal(list.begin(), list.end(), loaded.begin()) );
+
+  IVMPG::EnumerationControl ctl;
+  ctl.cancel();
+  tree = F::S2xS4.elements_of_depth_tree(20, 20, &ctl);
+  BOOST_CHECK( tree.truncated );
+  BOOST_CHECK( tree.begin() == tree.end() );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( stabilizer_order_test, F, Fixtures, F )
+{
+  using G = typename F::GroupType;
+  BOOST_CHECK_EQUAL( F::S2xS4.order(), 48u );
+  BOOST_CHECK_EQUAL( F::S2xS4.stabilizer_order({}), 48u );
+  BOOST_CHECK_EQUAL( F::S2xS4.stabilizer_order({1,0,1,1,0,0}), 4u );  // 2! 2! in S4
+  const auto binomial = [](uint64_t n, uint64_t k) {
+    uint64_t res = 1;
+    for (uint64_t i = 1; i <= k; i++) res = res * (n - k + i) / i;
+    return res;
+  };
+  // The orbits of the vectors of sum d partition the C(d+N-1, N-1) vectors
+  for (const G *g : {&(F::g_Borie), &(F::S2xS4), &(F::S3)})
+    for (uint64_t depth : {0, 1, 5, 8}) {
+      const auto list = g->elements_of_depth(depth);
+      const auto stabs = g->elements_of_depth_stabilizers(depth, depth);
+      BOOST_REQUIRE_EQUAL( stabs.size(), list.size() );
+      uint64_t total = 0;
+      auto it = list.begin();
+      for (const auto &vs : stabs) {
+	BOOST_CHECK_EQUAL( vs.first, *it++ );
+	BOOST_CHECK_EQUAL( g->order() % vs.second, 0u );
+	total += g->order() / vs.second;
+      }
+      BOOST_CHECK_EQUAL( total, binomial(depth + g->N - 1, g->N - 1) );
+    }
+  uint64_t total = 0;
+  for (const auto &vs : F::g_Borie.elements_of_evaluation_stabilizers({8, 8}))
+    total += F::g_Borie.order() / vs.second;
+  BOOST_CHECK_EQUAL( total, binomial(16, 8) );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( canonical_parallel_test, F, Fixtures, F )
+{
+  using G = typename F::GroupType;
+  typename G::TemporaryStorage st;
+  for (const G *g : {&(F::g_Borie), &(F::S2xS4), &(F::S3), &(F::g100)})
+    for (uint64_t depth : {1, 4, 7})
+      for (const auto &w : g->elements_of_depth(depth))
+	for (const auto &t : g->sgs[0]) {
+	  const auto v = w.permuted(t);
+	  // A zero threshold splits all the frontiers in blocks
+	  for (size_t threshold : {size_t(0), size_t(8), ~size_t(0)}) {
+	    BOOST_CHECK_EQUAL( g->is_canonical_parallel(v, st, threshold),
+			       g->is_canonical(v, st) );
+	    BOOST_CHECK_EQUAL( g->canonical_parallel(v, st, threshold), w );
+	  }
+	}
+}
+
+// S8 acting on 0..7 and 8..15 at the same time: the vectors constant on 0..7
+// have frontiers of up to 8! images, more than the bounded sets can hold.
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( frontier_overflow_test, F, Fixtures, F )
+{
+  using G = typename F::GroupType;
+  using P = typename G::StrongGeneratingSet::value_type::value_type;
+  using V = typename F::VectType;
+  const G g = G::from_generators("S8 diagonal", 16,
+    {P({1,0,2,3,4,5,6,7,9,8}), P({1,2,3,4,5,6,7,0,9,10,11,12,13,14,15,8})});
+  BOOST_CHECK_EQUAL( g.order(), 40320u );
+  typename G::TemporaryStorage st;
+  const V canon({0,0,0,0,0,0,0,0,7,6,5,4,3,2,1,0});
+  const V other({0,0,0,0,0,0,0,0,0,1,2,3,4,5,6,7});
+  BOOST_CHECK( g.is_canonical(canon, st) );
+  BOOST_CHECK( g.is_canonical(canon) );
+  BOOST_CHECK( not g.is_canonical(other, st) );
+  BOOST_CHECK_EQUAL( g.canonical(other, st), canon );
+  BOOST_CHECK_EQUAL( g.canonical(other), canon );
+  BOOST_CHECK_EQUAL( g.stabilizer_order(canon, st), 1u );
+  // The sets of the storage are usable again after an overflow
+  BOOST_CHECK( g.is_canonical(V({0,0,0,0,0,0,0,0,1}), st) );
+  BOOST_CHECK( not g.is_canonical(V({0,0,0,0,0,0,0,0,0,1}), st) );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( sort_transversals_test, F, Fixtures, F )
+{
+  using G = typename F::GroupType;
+  typename G::TemporaryStorage st;
+  for (const G *g : {&(F::g_Borie), &(F::S2xS4), &(F::S3)}) {
+    G sorted = *g;
+    sorted.sort_transversals(6, 10);
+    BOOST_CHECK( sorted.check_sgs() );
+    BOOST_CHECK_EQUAL( sorted.fingerprint(), g->fingerprint() );
+    BOOST_CHECK_EQUAL( sorted.sym_tail, g->sym_tail );
+    for (uint64_t i = 0; i < g->sgs.size(); i++) {
+      BOOST_REQUIRE_EQUAL( sorted.sgs[i].size(), g->sgs[i].size() );
+      BOOST_CHECK( std::is_permutation(sorted.sgs[i].begin(), sorted.sgs[i].end(),
+				       g->sgs[i].begin()) );
+    }
+    for (uint64_t depth : {0, 5, 10}) {
+      const auto list = g->elements_of_depth(depth);
+      const auto sorted_list = sorted.elements_of_depth(depth);
+      BOOST_REQUIRE_EQUAL( sorted_list.size(), list.size() );
+      BOOST_CHECK( std::equal(list.begin(), list.end(), sorted_list.begin()) );
+    }
+    for (const auto &level : g->elements_of_depth_levels(6, 6))
+      for (const auto &v : level)
+	for (uint64_t j = 0; j < g->N; j++)
+	  BOOST_CHECK_EQUAL( sorted.is_canonical(g->ith_child(v, j), st),
+			     g->is_canonical(g->ith_child(v, j), st) );
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( elements_of_depth_levels_test, F, Fixtures, F )
+{
+  const auto levels = F::g_Borie.elements_of_depth_levels(12, 12);
+  BOOST_REQUIRE_EQUAL( levels.size(), 13u );
+  for (uint64_t depth = 0; depth <= 12; depth++) {
+    const auto list = F::g_Borie.elements_of_depth(depth);
+    BOOST_REQUIRE_EQUAL( levels[depth].size(), list.size() );
+    BOOST_CHECK( std::equal(list.begin(), list.end(), levels[depth].begin()) );
+  }
+  // Bounded coordinates
+  const auto bounded = F::S2xS4.elements_of_depth_levels(10, 2);
+  BOOST_REQUIRE_EQUAL( bounded.size(), 11u );
+  for (uint64_t depth = 0; depth <= 10; depth++)
+    BOOST_CHECK_EQUAL( bounded[depth].size(), F::S2xS4.elements_of_depth_number(depth, 2) );
+
+  IVMPG::EnumerationControl ctl(100);
+  const auto partial = F::g_Borie.elements_of_depth_levels(12, 12, &ctl);
+  BOOST_CHECK( ctl.truncated() );
+  BOOST_CHECK_EQUAL( partial.size(), 6u );  // 1 + 1 + 2 + 6 + 14 + 25 vectors
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( canonical_rows_test, F, Fixtures, F )
+{
+  using G = typename F::GroupType;
+  using V = typename F::VectType;
+  const G &g = F::g_Borie;
+  // All the vectors of sum 3, one unused coordinate between the rows
+  const size_t stride = g.N + 1;
+  std::vector<typename G::entry> in;
+  std::vector<V> vects;
+  for (size_t i = 0; i < g.N; i++)
+    for (size_t j = i; j < g.N; j++)
+      for (size_t k = j; k < g.N; k++) {
+	V v {};
+	v[i]++; v[j]++; v[k]++;
+	vects.push_back(v);
+	for (size_t l = 0; l < stride; l++) in.push_back(l < g.N ? v[l] : 77);
+      }
+  const size_t n = vects.size();
+  std::vector<typename G::entry> out(n * g.N);
+  std::vector<uint8_t> is_can(n);
+  g.canonical_rows(in.data(), n, stride, out.data());
+  g.is_canonical_rows(in.data(), n, stride, is_can.data());
+  size_t canonicals = 0;
+  for (size_t i = 0; i < n; i++) {
+    const V can = g.canonical(vects[i]);
+    for (size_t j = 0; j < g.N; j++) BOOST_CHECK_EQUAL( out[i*g.N + j], can[j] );
+    BOOST_CHECK_EQUAL( bool(is_can[i]), g.is_canonical(vects[i]) );
+    canonicals += is_can[i];
+  }
+  BOOST_CHECK_EQUAL( canonicals, g.elements_of_depth(3).size() );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( arena_allocator_test, F, Fixtures, F )
+{
+  using V = typename F::VectType;
+  using Alloc = IVMPG::Container::ArenaAllocator<V>;
+  IVMPG::Container::MonotonicArena arena(1 << 16);
+  IVMPG::Container::ArenaScope scope(arena);
+  {
+    auto res = F::g_Borie.elements_of_depth(10, 10, Alloc(arena));
+    auto ref = F::g_Borie.elements_of_depth(10);
+    BOOST_CHECK_EQUAL( res.size(), ref.size() );
+    BOOST_CHECK( std::equal(res.begin(), res.end(), ref.begin()) );
+    BOOST_CHECK_GT( arena.reserved(), 0u );
+    BOOST_CHECK_EQUAL( F::S2xS4.elements_of_evaluation(V({3,3}), Alloc(arena)).size(), 3u );
+    BOOST_CHECK_EQUAL( F::S2xS4.elements_of_degree(10, {}, Alloc(arena)).size(), 191u );
+  }
+  arena.release();
+  BOOST_CHECK_EQUAL( arena.reserved(), 0u );
+  // Chunks larger than the default size
+  auto *big = Alloc(arena).allocate(1 << 16);
+  big[(1 << 16) - 1] = V({1});
+  BOOST_CHECK_GE( arena.reserved(), (1u << 16) * sizeof(V) );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( large_group_test, F, LargeFixtures, F )
+{
+  BOOST_CHECK(F::S7_edges.check_sgs());
+  // Multigraphs on 7 vertices, checked with Burnside lemma
+  std::vector<size_t> multigraphs {1, 1, 3, 8, 22, 60, 173, 471, 1303};
+  for (size_t i=0; i<multigraphs.size(); i++)
+    BOOST_CHECK_EQUAL( F::S7_edges.elements_of_depth(i).size(), multigraphs[i] );
+  // Simple graphs on 7 vertices (OEIS A008406)
+  std::vector<size_t> graphs {1, 1, 2, 5, 10, 21, 41, 65, 97, 131, 148,
+                              148, 131, 97, 65, 41, 21, 10, 5, 2, 1, 1, 0};
+  for (size_t i=0; i<graphs.size(); i++)
+    BOOST_CHECK_EQUAL( F::S7_edges.elements_of_depth(i, 1).size(), graphs[i] );
+  // Intra-query parallel canonical tests
+  typename F::GroupType::TemporaryStorage st;
+  for (const auto &w : F::S7_edges.elements_of_depth(6, 1))
+    for (const auto &t : F::S7_edges.sgs[0]) {
+      const auto v = w.permuted(t);
+      BOOST_CHECK_EQUAL( F::S7_edges.is_canonical_parallel(v, st, 0),
+			 F::S7_edges.is_canonical(v, st) );
+      BOOST_CHECK_EQUAL( F::S7_edges.canonical_parallel(v, st, 0), w );
+      BOOST_CHECK_EQUAL( F::S7_edges.canonical(v), w );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( elements_of_depth_wide_test )
+{
+  // Depth larger than 255 overflow Perm16
+  using G = IVMPG::PermutationGroup< IVMPG::Perm16w >;
+  const G &S3 = IVMPG::GroupExamples<G>::S3;
+  BOOST_CHECK_EQUAL( S3.elements_of_depth(300).size(), 7651u ); // round((300+3)^2/12)
+  BOOST_CHECK_EQUAL( S3.elements_of_depth(300).front(), G::vect({300}) );
+}
+
+BOOST_AUTO_TEST_CASE( statistics_test )
+{
+  using G = IVMPG::PermutationGroup< IVMPG::Perm16 >;
+  const G &g_Borie = IVMPG::GroupExamples<G>::g_Borie;
+  auto &stats = IVMPG::statistics();
+  stats.reset();
+  g_Borie.elements_of_depth_number(10);
+  BOOST_CHECK_EQUAL( stats.collect().requests, 0u );
+  stats.enable();
+  BOOST_CHECK_EQUAL( g_Borie.elements_of_depth_number(10), 545u );
+  stats.enable(false);
+  const IVMPG::Statistics st = stats.collect();
+  BOOST_CHECK_GT( st.requests, 0u );
+  BOOST_CHECK_GT( st.frontiers, 0u );
+  BOOST_CHECK_LE( st.inserted, st.requests );
+  // Far less than one collision per insertion
+  BOOST_CHECK_LT( st.collisions * 100, st.requests );
+  // The canonical vectors of degree 1..10, the leaves are not expanded
+  BOOST_REQUIRE_EQUAL( st.nodes.size(), 10u );
+  BOOST_REQUIRE_EQUAL( st.accepted.size(), 11u );
+  BOOST_CHECK_EQUAL( st.nodes[0], 1u );
+  BOOST_CHECK_EQUAL( st.nodes[5], 25u );
+  BOOST_CHECK_EQUAL( st.accepted[10], 545u );
+  for (size_t d=1; d<10; d++) BOOST_CHECK_EQUAL( st.nodes[d], st.accepted[d] );
+  uint64_t accepted = 0, rejected = 0, rejections = 0;
+  for (uint64_t n : st.accepted) accepted += n;
+  for (uint64_t n : st.rejected) rejected += n;
+  for (uint64_t n : st.rejection_level) rejections += n;
+  BOOST_CHECK_EQUAL( st.canonical_tests, accepted + rejected );
+  BOOST_CHECK_EQUAL( rejections, rejected );
+  BOOST_CHECK_GT( st.nanoseconds, 0u );
+  stats.reset();
+  BOOST_CHECK_EQUAL( stats.collect().requests, 0u );
+}
+
+BOOST_AUTO_TEST_CASE( tracer_test )
+{
+  using G = IVMPG::PermutationGroup< IVMPG::Perm16 >;
+  const G &g_Borie = IVMPG::GroupExamples<G>::g_Borie;
+  auto &tracer = IVMPG::tracer();
+  tracer.reset();
+  g_Borie.elements_of_depth_number(10);
+  BOOST_CHECK( tracer.events().empty() );
+  tracer.enable();
+  BOOST_CHECK_EQUAL( g_Borie.elements_of_depth_number(10), 545u );
+  tracer.disable();
+  const auto events = tracer.events();
+  BOOST_REQUIRE( not events.empty() );
+  BOOST_CHECK_EQUAL( tracer.dropped(), 0u );
+  const auto enumeration = std::find_if(events.begin(), events.end(),
+    [](const IVMPG::TraceEvent &ev) { return std::string(ev.name) == "enumeration"; });
+  BOOST_REQUIRE( enumeration != events.end() );
+  BOOST_CHECK_EQUAL( enumeration->depth, 0u );
+  BOOST_CHECK_EQUAL( enumeration->root_size, 16u );
+  for (const auto &ev : events) {
+    BOOST_CHECK_GE( ev.start, enumeration->start );
+    BOOST_CHECK_LE( ev.start + ev.duration, enumeration->start + enumeration->duration );
+  }
+  std::ostringstream out;
+  tracer.write_json(out);
+  const std::string json = out.str();
+  BOOST_CHECK_EQUAL( json.substr(0, 17), "{\"displayTimeUnit" );
+  BOOST_CHECK_EQUAL( json.substr(json.size() - 3), "]}\n" );
+  BOOST_CHECK_NE( json.find("\"name\":\"subtree\""), std::string::npos );
+  tracer.reset();
+  BOOST_CHECK( tracer.events().empty() );
+}
+
+BOOST_AUTO_TEST_CASE( cpu_dispatch_test )
+{
+  using G16 = IVMPG::PermutationGroup< IVMPG::Perm16 >;
+  using G32 = IVMPG::PermutationGroup< IVMPG::Perm32 >;
+  using G64 = IVMPG::PermutationGroup< IVMPG::Perm64 >;
+  const G16 &g_Borie = IVMPG::GroupExamples<G16>::g_Borie;
+  const G32 &S7_edges32 = IVMPG::GroupExamples<G32>::S7_edges;
+  const G64 &S7_edges = IVMPG::GroupExamples<G64>::S7_edges;
+  const IVMPG::ISA initial = IVMPG::dispatch_isa();
+  // Every kernel the processor can run gives the same results
+  for (IVMPG::ISA isa : {IVMPG::ISA::SSE4_2, IVMPG::ISA::AVX2, IVMPG::ISA::AVX512}) {
+    if (isa > IVMPG::cpu_isa()) break;
+    IVMPG::set_dispatch_isa(isa);
+    BOOST_CHECK( IVMPG::dispatch_isa() == isa );
+    BOOST_CHECK_EQUAL( g_Borie.elements_of_depth_number(10), 545u );
+    BOOST_CHECK_EQUAL( S7_edges32.elements_of_depth(8).size(), 1303u );
+    BOOST_CHECK_EQUAL( S7_edges.elements_of_depth(8).size(), 1303u );
+  }
+  IVMPG::set_dispatch_isa(IVMPG::ISA::AVX512);
+  BOOST_CHECK( IVMPG::dispatch_isa() == IVMPG::cpu_isa() );
+  IVMPG::set_dispatch_isa(initial);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,419 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+// Command line enumerator: the canonical vectors under a permutation group
+// read from a file are written while the walk is running.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "config.h"
+#include "group16.hpp"
+#include "packed_file.hpp"
+#include "enumeration_cache.hpp"
+
+using namespace std;
+using namespace IVMPG;
+
+using Group = PermutationGroup16;
+using Tree = CanonicalTree<Group::vect>;
+
+static void show_usage(string name) {
+  cerr << "Usage: " << name << " [options] <group file>\n"
+"Enumerate the integer vectors modulo the action of a permutation group.\n"
+"\n"
+"  -d, --depth <d>           vectors of sum d\n"
+"  -r, --range <a>:<b>       vectors of sum a, a+1, ..., b\n"
+"  -m, --max-part <m>        with coordinates at most m (with -d or -r)\n"
+"  -e, --evaluation <e0,...> with e0 coordinates equal to 0, e1 to 1...\n"
+"  -c, --count               only print the number of vectors\n"
+"  -b, --bfs                 compute all the depths up to b at once, level by\n"
+"                            level in memory (with -d or -r)\n"
+"  -s, --stats               print the statistics of the walk on stderr\n"
+"  -f, --format <format>     text:   one line per vector,\n"
+"                            binary: N bytes per vector,\n"
+"                            packed: bit packed file (see packed_file.hpp)\n"
+"                            tree:   canonical tree (see canonical_tree.hpp),\n"
+"                                    with a single --depth\n"
+"  -o, --output <file>       instead of the standard output\n"
+"  -n, --threads <n>         number of Cilk workers\n"
+"      --max-results <n>     stop after n vectors (not with -c)\n"
+"      --timeout <s>         stop after s seconds, the count of a depth\n"
+"                            being then only reported as truncated on stderr\n"
+"      --sort-transversals <d>\n"
+"                            first reorder the strong generating set for the\n"
+"                            canonical tests of the vectors of sum up to d\n"
+"      --cache <dir>         serve the counts and the listings from the cache\n"
+"                            directory, storing there the complete new ones\n"
+"  -u, --unpack <file>       print the vectors of a packed or tree file instead\n"
+"\n"
+"The group file gives the degree and either generators or a strong\n"
+"generating set, the permutations being the lists of the images of\n"
+"0, 1, ..., N-1. The lines starting with '#' are ignored.\n"
+"  name <name>\n"
+"  degree <N>\n"
+"  generator <images>    (repeated)\n"
+"or instead of the generators, for each transversal of the stabilizer chain\n"
+"  level\n"
+"  <images>              (repeated, starting with the identity)\n";
+  exit(1);
+}
+
+static void fail(const string &msg) {
+  cerr << "ivmpg: " << msg << endl;
+  exit(2);
+}
+
+static Perm16 read_perm(istringstream &line, uint64_t N) {
+  Perm16 res;
+  uint64_t i = 0, x;
+  for (; line >> x; i++) {
+    if (i >= N or x >= N) fail("permutation larger than the degree");
+    res[i] = x;
+  }
+  if (not line.eof() or i != N or not res.is_permutation(N)) fail("invalid permutation");
+  return res;
+}
+
+static Group read_group(const string &filename) {
+  ifstream file(filename);
+  if (not file) fail("unable to open " + filename);
+  string name = filename, line;
+  uint64_t N = 0;
+  vector<Perm16> gens;
+  Group::StrongGeneratingSet sgs;
+  while (getline(file, line)) {
+    istringstream in(line);
+    string key;
+    if (not (in >> key) or key[0] == '#') continue;
+    if (key == "name") getline(in >> ws, name);
+    else if (key == "degree") {
+      if (not (in >> N) or N == 0 or N > Perm16::Size) fail("degree should be in 1..16");
+    }
+    else if (N == 0) fail("the degree should be given first");
+    else if (key == "generator") gens.push_back(read_perm(in, N));
+    else if (key == "level") sgs.emplace_back();
+    else if (not sgs.empty()) {
+      istringstream images(line);
+      sgs.back().push_back(read_perm(images, N));
+    }
+    else fail("unexpected line: " + line);
+  }
+  if (N == 0) fail("no degree in " + filename);
+  if (sgs.empty()) return Group::from_generators(name, N, gens);
+  if (not gens.empty()) fail("both generators and a strong generating set given");
+  const Perm16 id = Perm16::one();
+  while (sgs.size() < N) sgs.push_back({id});
+  for (const auto &transversal : sgs)
+    if (transversal.empty()) fail("empty transversal");
+  Group res(name, N, sgs);
+  if (not res.check_sgs()) fail("invalid strong generating set");
+  return res;
+}
+
+static uint64_t parse_uint(const string &s) {
+  char *end;
+  const uint64_t res = strtoull(s.c_str(), &end, 10);
+  if (s.empty() or *end != '\0') fail("invalid number " + s);
+  return res;
+}
+
+// A number of seconds, at most about 30 years so that the deadline fits in
+// the clock.
+static double parse_seconds(const string &s) {
+  char *end;
+  const double res = strtod(s.c_str(), &end);
+  if (s.empty() or *end != '\0' or not (res >= 0 and res <= 1e9)) fail("invalid number " + s);
+  return res;
+}
+
+// Written by the sink of the row collector, under its lock.
+struct Output {
+  ostream &out;
+  const bool binary;
+  const size_t width;
+  PackedWriter *packed;
+  string text;
+
+  static void sink(void *context, Group::RowCollector::chunk &rows) {
+    Output &o = *static_cast<Output *>(context);
+    if (o.packed) {
+      o.packed->push(rows.data(), rows.size() / o.width);
+      return;
+    }
+    if (o.binary) {
+      o.out.write(reinterpret_cast<const char *>(rows.data()), rows.size());
+      return;
+    }
+    o.text.clear();
+    for (size_t i = 0; i < rows.size(); i++) {
+      o.text += to_string(unsigned(rows[i]));
+      o.text += (i % o.width == o.width - 1) ? '\n' : ' ';
+    }
+    o.out << o.text;
+  }
+};
+
+template <class Vectors>
+static void print_vectors(const Vectors &vects, size_t N, ostream &out) {
+  string text;
+  for (const auto &v : vects) {
+    text.clear();
+    for (size_t i = 0; i < N; i++) {
+      text += to_string(unsigned(v[i]));
+      text += (i == N - 1) ? '\n' : ' ';
+    }
+    out << text;
+  }
+}
+
+// Send the rows of a cached listing to the output, as many as ctl allows
+static uint64_t copy_rows(const PackedReader &in, Output &out, EnumerationControl &ctl) {
+  vector<Vect16> block;
+  Group::RowCollector::chunk rows;
+  uint64_t res = 0;
+  for (uint64_t b = 0; b < in.nblocks() and not ctl.stopped(); b++) {
+    block.resize(in.block_size(b));
+    in.unpack_block(b, block.data());
+    rows.clear();
+    for (const Vect16 &v : block) {
+      if (not ctl.take_result()) break;
+      rows.insert(rows.end(), v.p.begin(), v.p.begin() + out.width);
+      res++;
+    }
+    Output::sink(&out, rows);
+  }
+  return res;
+}
+
+static uint64_t copy_level(const Group::level &vects, Output &out) {
+  Group::RowCollector::chunk rows;
+  for (size_t b = 0; b < vects.size(); b += 4096) {
+    rows.clear();
+    for (size_t k = b; k < min(vects.size(), b + 4096); k++)
+      rows.insert(rows.end(), vects[k].p.begin(), vects[k].p.begin() + out.width);
+    Output::sink(&out, rows);
+  }
+  return vects.size();
+}
+
+// Either a packed file or a tree file, recognized by its magic.
+static int unpack_file(const string &filename, const string &output) {
+  ofstream file;
+  if (not output.empty()) {
+    file.open(output);
+    if (not file) fail("unable to open " + output);
+  }
+  ostream &out = output.empty() ? cout : file;
+  ifstream tree_file(filename, ios::binary);
+  char magic[sizeof(Tree::magic)];
+  if (tree_file.read(magic, sizeof(magic)) and
+      memcmp(magic, Tree::magic, sizeof(magic)) == 0) {
+    Tree tree;
+    tree_file.seekg(0);
+    tree.load(tree_file);
+    print_vectors(tree, tree.N, out);
+  } else {
+    const PackedReader in(filename);
+    print_vectors(in, in.header().N, out);
+  }
+  out.flush();
+  if (not out) fail("write error");
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  ios::sync_with_stdio(false);
+
+  string group_file, output, format = "text", unpack, cache_dir;
+  uint64_t min_depth = 0, max_depth = 0, max_part = 0, sort_depth = 0;
+  bool depth = false, has_max_part = false, count = false, stats = false, bfs = false;
+  vector<uint64_t> evaluation;
+  EnumerationControl ctl;
+
+  for (int i = 1; i < argc; i++) {
+    const string opt = argv[i];
+    const auto arg = [&]() -> string {
+      if (i + 1 >= argc) show_usage(argv[0]);
+      return argv[++i];
+    };
+    if (opt == "-d" or opt == "--depth") {
+      depth = true;
+      min_depth = max_depth = parse_uint(arg());
+    }
+    else if (opt == "-r" or opt == "--range") {
+      const string range = arg();
+      const size_t colon = range.find(':');
+      if (colon == string::npos) fail("invalid range " + range);
+      depth = true;
+      min_depth = parse_uint(range.substr(0, colon));
+      max_depth = parse_uint(range.substr(colon + 1));
+    }
+    else if (opt == "-m" or opt == "--max-part") {
+      has_max_part = true;
+      max_part = parse_uint(arg());
+    }
+    else if (opt == "-e" or opt == "--evaluation") {
+      istringstream in(arg());
+      string x;
+      while (getline(in, x, ',')) evaluation.push_back(parse_uint(x));
+    }
+    else if (opt == "-c" or opt == "--count") count = true;
+    else if (opt == "-s" or opt == "--stats") stats = true;
+    else if (opt == "-b" or opt == "--bfs") bfs = true;
+    else if (opt == "-f" or opt == "--format") format = arg();
+    else if (opt == "-o" or opt == "--output") output = arg();
+    else if (opt == "-n" or opt == "--threads") {
+      const string nproc = arg();
+#ifdef USE_CILK
+      if (__cilkrts_set_param("nworkers", nproc.c_str()) != __CILKRTS_SET_PARAM_SUCCESS)
+	cerr << "Failed to set the number of Cilk workers" << endl;
+#else
+      if (parse_uint(nproc) > 1) cerr << "Compiled without Cilk: using one thread" << endl;
+#endif
+    }
+    else if (opt == "--max-results") ctl.max_results = parse_uint(arg());
+    else if (opt == "--timeout") ctl.set_timeout_seconds(parse_seconds(arg()));
+    else if (opt == "-u" or opt == "--unpack") unpack = arg();
+    else if (opt == "--cache") cache_dir = arg();
+    else if (opt == "--sort-transversals") sort_depth = parse_uint(arg());
+    else if (opt[0] == '-' or not group_file.empty()) show_usage(argv[0]);
+    else group_file = opt;
+  }
+  if (not unpack.empty()) {
+    try { return unpack_file(unpack, output); }
+    catch (const exception &e) { fail(e.what()); }
+  }
+  if (group_file.empty() or depth == not evaluation.empty()) show_usage(argv[0]);
+  if (format != "text" and format != "binary" and format != "packed" and format != "tree")
+    show_usage(argv[0]);
+  if ((format == "packed" or format == "tree") and output.empty())
+    fail("the " + format + " format needs --output");
+  if (format == "tree" and (not depth or min_depth != max_depth or count))
+    fail("the tree format needs a single --depth");
+  if (format == "tree" and ctl.max_results != numeric_limits<uint64_t>::max())
+    fail("--max-results is not supported by the tree format");
+  if (format == "tree" and not cache_dir.empty())
+    fail("--cache is not supported by the tree format");
+  if (count and ctl.max_results != numeric_limits<uint64_t>::max())
+    fail("--max-results is not supported with --count");
+  if (has_max_part and not depth) fail("--max-part requires --depth or --range");
+  if (bfs and (not depth or format == "tree" or not cache_dir.empty()))
+    fail("--bfs requires --depth or --range, without --cache or the tree format");
+
+  Group g = read_group(group_file);
+  // This only changes the speed of the canonical tests, not the results
+  g.sort_transversals(sort_depth, has_max_part ? max_part : sort_depth);
+  Group::vect eval {};
+  if (not depth) {
+    uint64_t sum = 0;
+    if (evaluation.size() > Group::vect::Size) fail("evaluation too long");
+    for (size_t i = 0; i < evaluation.size(); i++) {
+      if (evaluation[i] > 255) fail("evaluation entries should be at most 255");
+      eval[i] = evaluation[i];
+      sum += evaluation[i];
+    }
+    if (sum != g.N) fail("the evaluation should be of sum " + to_string(g.N));
+  }
+  if (stats) statistics().enable(true);
+
+  unique_ptr<EnumerationCache> cache;
+  if (not cache_dir.empty()) {
+    try { cache.reset(new EnumerationCache(cache_dir)); }
+    catch (const exception &e) { fail(e.what()); }
+  }
+
+  ofstream file;
+  unique_ptr<PackedWriter> packed;
+  if (format == "packed") {
+    try { packed.reset(new PackedWriter(output, g.fingerprint(), g.N)); }
+    catch (const exception &e) { fail(e.what()); }
+    if (depth and min_depth == max_depth)
+      packed->set_depth(min_depth, has_max_part ? max_part : min_depth);
+    if (not depth) packed->set_evaluation(eval);
+  }
+  else if (not output.empty()) {
+    file.open(output, ios::binary);
+    if (not file) fail("unable to open " + output);
+  }
+  Output out {output.empty() or packed ? cout : file, format == "binary", g.N, packed.get()};
+  Group::RowCollector rows(g.N, 4096, Output::sink, &out);
+
+  // The listings are cached complete, max_results only applying to the output
+  EnumerationControl cache_ctl;
+  cache_ctl.deadline = ctl.deadline;
+  const auto cached = [&](const PackedReader &in) {
+    const uint64_t res = copy_rows(in, out, ctl);
+    if (cache_ctl.truncated()) ctl.cancel();
+    return res;
+  };
+
+  const auto start = chrono::steady_clock::now();
+  uint64_t total = 0;
+  if (format == "tree") {
+    const Tree tree = g.elements_of_depth_tree(min_depth, has_max_part ? max_part : min_depth, &ctl);
+    tree.save(file);
+    total = tree.size();
+  }
+  else if (bfs) {
+    const auto levels = g.elements_of_depth_levels(max_depth,
+						   has_max_part ? max_part : max_depth, &ctl);
+    for (uint64_t d = min_depth; d < levels.size(); d++) {
+      if (count) out.out << d << " " << levels[d].size() << "\n";
+      else copy_level(levels[d], out);
+      total += levels[d].size();
+    }
+  }
+  else if (depth) {
+    for (uint64_t d = min_depth; d <= max_depth and not ctl.stopped(); d++) {
+      const uint64_t mp = has_max_part ? max_part : d;
+      if (count) {
+	const uint64_t res = cache ? cache->elements_of_depth_number(g, d, mp, &ctl) :
+	  g.elements_of_depth_number(d, mp, &ctl);
+	total += res;
+	// The count of a stopped run is only a lower bound
+	if (ctl.truncated()) cerr << "depth " << d << ": truncated after " << res << " vectors\n";
+	else out.out << d << " " << res << "\n";
+      }
+      else if (cache) total += cached(cache->elements_of_depth(g, d, mp, &cache_ctl));
+      else total = g.elements_of_depth_rows(d, mp, rows, &ctl);
+    }
+  } else if (count) {
+    total = cache ? cache->elements_of_evaluation_number(g, eval, &ctl) :
+      g.elements_of_evaluation_number(eval, &ctl);
+    if (ctl.truncated()) cerr << "truncated after " << total << " vectors\n";
+    else out.out << total << "\n";
+  }
+  else if (cache) total = cached(cache->elements_of_evaluation(g, eval, &cache_ctl));
+  else total = g.elements_of_evaluation_rows(eval, rows, &ctl);
+  const chrono::duration<double> time = chrono::steady_clock::now() - start;
+  if (packed) packed->close();
+  out.out.flush();
+
+  if (stats) {
+    cerr << g.name << ": " << total << " vectors (time = " << time.count() << "s)";
+    if (ctl.truncated()) cerr << ", truncated";
+    cerr << "\n" << statistics().collect() << endl;
+  }
+  if (not out.out) fail("write error");
+  return ctl.truncated() ? 3 : 0;
+}
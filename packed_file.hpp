@@ -0,0 +1,315 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _PACKED_FILE_HPP
+#define _PACKED_FILE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <x86intrin.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "perm16.hpp"
+
+namespace IVMPG {
+
+// Compact file format for the results of an enumeration. The vectors of N
+// coordinates are stored by blocks of rows, each block being bit packed with
+// the width of its largest coordinate:
+//
+//   header | bits, rows of the block 0 | bits, rows of the block 1 | ...
+//          | offsets of the blocks and of their end | padding
+//
+// The coordinates are packed from the low bits of each byte. All the fields
+// are little endian.
+struct PackedHeader {
+  static const constexpr uint64_t no_depth = ~uint64_t(0);
+
+  char magic[8];          // "IVMPGPK1"
+  uint64_t fingerprint;   // of the group (see PermutationGroup::fingerprint)
+  uint32_t N;             // number of coordinates
+  uint32_t block_rows;    // number of rows of all the blocks but the last one
+  uint64_t depth;         // no_depth for the elements of an evaluation
+  uint64_t max_part;
+  uint8_t evaluation[16];
+  uint64_t count;         // number of rows
+  uint64_t nblocks;
+  uint64_t index;         // file offset of the nblocks+1 block offsets
+};
+
+static_assert(sizeof(PackedHeader) == 80, "PackedHeader should not be padded !");
+
+namespace Packed {
+
+const char magic[8] = {'I', 'V', 'M', 'P', 'G', 'P', 'K', '1'};
+// Zeros at the end of the file, so that the reader can load 16 bytes from
+// any place of a row.
+const size_t padding = 32;
+
+inline unsigned width(uint8_t max) { return max ? 32 - __builtin_clz(max) : 1; }
+
+// Unpack the rows of a block of a given width. The row r starts at the bit
+// r*N*bits; the coordinate i at the bit phase + i*bits of the bytes of the
+// row, phase being the position of the row in its first byte. For each phase
+// and each half of the vector, the shuffle gathers in the 16 bits lane i the
+// two bytes holding the coordinate i, and the multiplication shifts the
+// coordinate to the bits 8..15 of the lane.
+class RowUnpacker {
+
+  __m128i shuffle[8][2], mult[8][2];
+  uint64_t offset[8][2];
+  __m128i mask;
+  uint64_t row_bits;
+
+public:
+
+  RowUnpacker(unsigned N, unsigned bits) : row_bits(uint64_t(N) * bits) {
+    mask = _mm_set1_epi16((1 << bits) - 1);
+    for (unsigned phase = 0; phase < 8; phase++)
+      for (unsigned h = 0; h < 2; h++) {
+	alignas(16) uint8_t shuf[16];
+	alignas(16) uint16_t mul[8];
+	offset[phase][h] = (phase + 8 * h * bits) / 8;
+	for (unsigned j = 0; j < 8; j++) {
+	  const unsigned i = 8 * h + j;
+	  const unsigned bit = phase + i * bits - 8 * offset[phase][h];
+	  shuf[2*j]   = i < N ? bit / 8 : 0x80;
+	  shuf[2*j+1] = i < N ? bit / 8 + 1 : 0x80;
+	  mul[j] = 1 << (8 - bit % 8);
+	}
+	shuffle[phase][h] = _mm_load_si128(reinterpret_cast<const __m128i *>(shuf));
+	mult[phase][h] = _mm_load_si128(reinterpret_cast<const __m128i *>(mul));
+      }
+  }
+
+  // The row r of the rows starting at data
+  Vect16 operator()(const uint8_t *data, uint64_t r) const {
+    const uint64_t start = r * row_bits;
+    const unsigned phase = start % 8;
+    const uint8_t *row = data + start / 8;
+    __m128i half[2];
+    for (unsigned h = 0; h < 2; h++) {
+      const __m128i bytes = _mm_loadu_si128(
+	reinterpret_cast<const __m128i *>(row + offset[phase][h]));
+      const __m128i lanes = _mm_mullo_epi16(_mm_shuffle_epi8(bytes, shuffle[phase][h]),
+					    mult[phase][h]);
+      half[h] = _mm_and_si128(_mm_srli_epi16(lanes, 8), mask);
+    }
+    Vect16 res;
+    res.v = _mm_packus_epi16(half[0], half[1]);
+    return res;
+  }
+};
+
+} //  namespace Packed
+
+
+// Writes a packed file. The header is written when closing the file.
+class PackedWriter {
+
+  std::ofstream out;
+  PackedHeader head;
+  std::vector<uint64_t> offsets;
+  std::vector<uint8_t> block;  // one byte per coordinate
+
+  void write_block() {
+    if (block.empty()) return;
+    uint8_t max = 0;
+    for (uint8_t x : block) max |= x;
+    const unsigned bits = Packed::width(max);
+    std::vector<uint8_t> packed(1 + (block.size() * bits + 7) / 8, 0);
+    packed[0] = bits;
+    uint64_t pos = 0;
+    for (uint8_t x : block) {
+      packed[1 + pos / 8] |= x << (pos % 8);
+      if (pos % 8 + bits > 8) packed[2 + pos / 8] |= x >> (8 - pos % 8);
+      pos += bits;
+    }
+    offsets.push_back(out.tellp());
+    out.write(reinterpret_cast<const char *>(packed.data()), packed.size());
+    head.nblocks++;
+    block.clear();
+  }
+
+public:
+
+  PackedWriter(const std::string &filename, uint64_t fingerprint, uint32_t N,
+	       uint32_t block_rows = 4096) : out(filename, std::ios::binary) {
+    if (not out) throw std::runtime_error("Unable to open " + filename);
+    if (N == 0 or N > Vect16::Size or block_rows == 0)
+      throw std::invalid_argument("Invalid packed file parameters");
+    std::memset(&head, 0, sizeof(head));
+    std::memcpy(head.magic, Packed::magic, sizeof(head.magic));
+    head.fingerprint = fingerprint;
+    head.N = N;
+    head.block_rows = block_rows;
+    head.depth = PackedHeader::no_depth;
+    out.write(reinterpret_cast<const char *>(&head), sizeof(head));
+  }
+  ~PackedWriter() {
+    try { if (out.is_open()) close(); }
+    catch (const std::exception &) {}
+  }
+
+  const PackedHeader &header() const { return head; }
+  void set_depth(uint64_t depth, uint64_t max_part) {
+    head.depth = depth;
+    head.max_part = max_part;
+  }
+  void set_evaluation(const Vect16 &eval) {
+    for (size_t i = 0; i < Vect16::Size; i++) head.evaluation[i] = eval[i];
+  }
+
+  // Append nrows contiguous rows of N coordinates
+  void push(const uint8_t *rows, size_t nrows) {
+    const size_t row_size = head.N;
+    for (size_t r = 0; r < nrows; r++, rows += row_size) {
+      block.insert(block.end(), rows, rows + row_size);
+      if (block.size() == head.block_rows * row_size) write_block();
+    }
+    head.count += nrows;
+  }
+  void push(const Vect16 &v) { push(v.p.data(), 1); }
+
+  void close() {
+    write_block();
+    offsets.push_back(out.tellp());
+    const std::vector<char> zeros((8 - offsets.back() % 8) % 8 + Packed::padding, 0);
+    out.write(zeros.data(), zeros.size() - Packed::padding);
+    head.index = out.tellp();
+    out.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    out.write(zeros.data(), Packed::padding);
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&head), sizeof(head));
+    out.close();
+    if (not out) throw std::runtime_error("Error while writing the packed file");
+  }
+};
+
+
+// Memory mapped packed file
+class PackedReader {
+
+  const uint8_t *data;
+  size_t length;
+  const PackedHeader *head;
+  const uint64_t *offsets;
+
+  void fail(const std::string &msg) {
+    if (data) munmap(const_cast<uint8_t *>(data), length);
+    throw std::runtime_error(msg);
+  }
+
+public:
+
+  explicit PackedReader(const std::string &filename) : data(nullptr), length(0) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Unable to open " + filename);
+    struct stat st;
+    if (fstat(fd, &st) == 0) length = st.st_size;
+    if (length >= sizeof(PackedHeader)) {
+      void *map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+      if (map != MAP_FAILED) data = static_cast<const uint8_t *>(map);
+    }
+    ::close(fd);
+    if (not data) fail("Unable to map " + filename);
+    madvise(const_cast<uint8_t *>(data), length, MADV_SEQUENTIAL);
+    head = reinterpret_cast<const PackedHeader *>(data);
+    offsets = reinterpret_cast<const uint64_t *>(data + head->index);
+    if (std::memcmp(head->magic, Packed::magic, sizeof(head->magic)) != 0 or
+	head->N == 0 or head->N > Vect16::Size or head->block_rows == 0 or
+	head->index % 8 != 0 or head->index > length or
+	head->nblocks != (head->count + head->block_rows - 1) / head->block_rows or
+	(length - head->index) / 8 < head->nblocks + 1 + Packed::padding / 8)
+      fail(filename + " is not a packed file");
+    for (uint64_t b = 0; b < head->nblocks; b++)
+      if (offsets[b] < sizeof(PackedHeader) or offsets[b] >= offsets[b+1] or
+	  offsets[b+1] > head->index or data[offsets[b]] == 0 or data[offsets[b]] > 8 or
+	  (offsets[b+1] - offsets[b] - 1) * 8 <
+	  uint64_t(block_size(b)) * head->N * data[offsets[b]])
+	fail(filename + " is corrupted");
+  }
+  PackedReader(const PackedReader &) = delete;
+  PackedReader(PackedReader &&other) :
+    data(other.data), length(other.length), head(other.head), offsets(other.offsets) {
+    other.data = nullptr;
+  }
+  ~PackedReader() { if (data) munmap(const_cast<uint8_t *>(data), length); }
+
+  const PackedHeader &header() const { return *head; }
+  uint64_t size() const { return head->count; }
+  uint64_t nblocks() const { return head->nblocks; }
+  size_t block_size(uint64_t b) const {
+    return b + 1 < head->nblocks ? head->block_rows :
+      head->count - b * head->block_rows;
+  }
+
+  // Unpack the rows of the block b in out, returning their number
+  size_t unpack_block(uint64_t b, Vect16 *out) const {
+    const uint8_t *block = data + offsets[b];
+    const Packed::RowUnpacker unpack(head->N, block[0]);
+    const size_t rows = block_size(b);
+    for (size_t r = 0; r < rows; r++) out[r] = unpack(block + 1, r);
+    return rows;
+  }
+  Vect16 operator[](uint64_t i) const {
+    const uint8_t *block = data + offsets[i / head->block_rows];
+    return Packed::RowUnpacker(head->N, block[0])(block + 1, i % head->block_rows);
+  }
+
+  // Unpacks the vectors block by block
+  class iterator : public std::iterator<std::input_iterator_tag, Vect16> {
+    const PackedReader *reader;
+    uint64_t b;
+    size_t r;
+    std::vector<Vect16> rows;
+
+    void load() {
+      r = 0;
+      rows.resize(reader->block_size(b));
+      reader->unpack_block(b, rows.data());
+    }
+
+  public:
+    iterator(const PackedReader *reader, uint64_t b) : reader(reader), b(b), r(0) {
+      if (b < reader->nblocks()) load();
+    }
+    const Vect16 &operator*() const { return rows[r]; }
+    const Vect16 *operator->() const { return &rows[r]; }
+    iterator &operator++() {
+      if (++r == rows.size() and ++b < reader->nblocks()) load();
+      return *this;
+    }
+    bool operator==(const iterator &other) const {
+      return b == other.b and (b >= reader->nblocks() or r == other.r);
+    }
+    bool operator!=(const iterator &other) const { return not (*this == other); }
+  };
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, nblocks()); }
+};
+
+} //  namespace IVMPG
+
+#endif // _PACKED_FILE_HPP
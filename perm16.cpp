@@ -14,6 +14,7 @@
 /******************************************************************************/
 
 #include "perm16.hpp"
+#include "perm16w.hpp"
 #include <iostream>
 
 namespace IVMPG {
@@ -28,4 +29,13 @@ std::ostream & operator<<(std::ostream & stream, Vect16 const &term) {
   return stream;
 }
 
+const constexpr size_t Vect16w::Size;
+
+std::ostream & operator<<(std::ostream & stream, Vect16w const &term) {
+  stream << "[" << unsigned(term[0]);
+  for (unsigned i=1; i < Vect16w::Size; i++) stream << "," << unsigned(term[i]);
+  stream << "]";
+  return stream;
+}
+
 } //  namespace IVMPG
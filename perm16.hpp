@@ -41,6 +41,32 @@ const char LAST_NON_ZERO = (_SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
 			    _SIDD_MASKED_NEGATIVE_POLARITY | _SIDD_MOST_SIGNIFICANT);
 
 
+// Bitonic sorting network for 16 bytes in decreasing order. At each stage,
+// every entry is compared with the entry at the given index, and keeps the
+// max if the mask is set and the min otherwise.
+constexpr const epi8 revsorting_network[10][2] = {
+  {epi8 {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14},
+   epi8 {255,0,0,255,255,0,0,255,255,0,0,255,255,0,0,255}},
+  {epi8 {2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13},
+   epi8 {255,255,0,0,0,0,255,255,255,255,0,0,0,0,255,255}},
+  {epi8 {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14},
+   epi8 {255,0,255,0,0,255,0,255,255,0,255,0,0,255,0,255}},
+  {epi8 {4,5,6,7,0,1,2,3,12,13,14,15,8,9,10,11},
+   epi8 {255,255,255,255,0,0,0,0,0,0,0,0,255,255,255,255}},
+  {epi8 {2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13},
+   epi8 {255,255,0,0,255,255,0,0,0,0,255,255,0,0,255,255}},
+  {epi8 {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14},
+   epi8 {255,0,255,0,255,0,255,0,0,255,0,255,0,255,0,255}},
+  {epi8 {8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7},
+   epi8 {255,255,255,255,255,255,255,255,0,0,0,0,0,0,0,0}},
+  {epi8 {4,5,6,7,0,1,2,3,12,13,14,15,8,9,10,11},
+   epi8 {255,255,255,255,0,0,0,0,255,255,255,255,0,0,0,0}},
+  {epi8 {2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13},
+   epi8 {255,255,0,0,255,255,0,0,255,255,0,0,255,255,0,0}},
+  {epi8 {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14},
+   epi8 {255,0,255,0,255,0,255,0,255,0,255,0,255,0,255,0}}
+};
+
 struct alignas(16) Vect16
 {
 
@@ -106,6 +132,34 @@ struct alignas(16) Vect16
   uint64_t last_zero(int bnd=Size) const { return search_index<LAST_ZERO>(bnd); }
   uint64_t first_zero(int bnd=Size) const { return search_index<FIRST_ZERO>(bnd); }
 
+  // Is the vector non increasing on the range [begin, end) ?
+  bool is_revsorted(size_t begin = 0, size_t end = Size) const {
+    if (end <= begin + 1) return true;
+    const __m128i next = _mm_srli_si128(v, 1);
+    const unsigned ge = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, next), v));
+    const unsigned range = ((1u << (end - 1)) - 1) & ~((1u << begin) - 1);
+    return (ge & range) == range;
+  }
+
+  // Sort the entries in [begin, end) in non increasing order
+  Vect16 revsorted(size_t begin = 0, size_t end = Size) const {
+    constexpr const __m128i idv = __m128i(epi8 {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15});
+    const __m128i before = _mm_cmpgt_epi8(_mm_set1_epi8(begin), idv);
+    const __m128i inside = _mm_andnot_si128(before,
+                                            _mm_cmpgt_epi8(_mm_set1_epi8(end), idv));
+    // Entries before begin are set to 255 and entries after end to 0 so that
+    // they are kept in place by the sort.
+    __m128i res = _mm_or_si128(before, _mm_and_si128(inside, v));
+    for (const auto &stage : revsorting_network) {
+      const __m128i other = _mm_shuffle_epi8(res, __m128i(stage[0]));
+      res = _mm_blendv_epi8(_mm_min_epu8(res, other), _mm_max_epu8(res, other),
+                            __m128i(stage[1]));
+    }
+    Vect16 sorted;
+    sorted.v = _mm_blendv_epi8(v, res, inside);
+    return sorted;
+  }
+
   bool is_permutation(const size_t k = Size) const {
     constexpr const __m128i idv = __m128i(epi8 {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15});
     uint64_t diff = unsigned(_mm_cmpestri(v, Size, idv, Size, LAST_DIFF));
@@ -154,11 +208,15 @@ namespace std {
 
   template<>
   struct hash<IVMPG::Vect16> {
+    // Both halves are hashed since the upper one is zero for the groups on
+    // at most 8 points. CRC32C mixes well the low bits which are used by
+    // bounded_set whatever its capacity.
     size_t operator () (const IVMPG::Vect16 &ar) const {
-      uint64_t v1 = _mm_extract_epi64(ar.v, 1);
-      return (v1*IVMPG::prime) >> 54;
+      return _mm_crc32_u64(_mm_crc32_u64(0, _mm_cvtsi128_si64(ar.v)),
+			   _mm_extract_epi64(ar.v, 1));
 
-      // Timing for a 1024 hash table with SET_STATISTIC defined
+      // Previous multiplicative hashes keeping the high bits.
+      // Timing for a 1024 hash table with the set statistics gathered
       //////////////////////////////////////////////////////////
       //                                             1 proc   8 proc  collision retry
       // return ((v1*prime + v0)*prime) >> 52;   // 7.39027  1.68039    0.0783%
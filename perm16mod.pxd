@@ -24,8 +24,8 @@ cdef class PermGroup16(SageObject):
     cdef list dom
 
     cpdef _check_sgs(self)
-    cpdef Vect16List elements_of_depth(self, int depth)
-    cpdef Vect16List elements_of_evaluation(self, Vect16 v)
+    cpdef Vect16List elements_of_depth(self, int depth, max_results=*, timeout=*)
+    cpdef Vect16List elements_of_evaluation(self, Vect16 v, max_results=*, timeout=*)
     cpdef bint is_canonical(self, Vect16 v)
     cpdef Vect16 canonical(self, Vect16 v)
 
@@ -36,6 +36,7 @@ cdef class Vect16(SageObject):
 cdef class Vect16List(object):
     cdef group16.PG16list _l
     cdef dom
+    cdef readonly bint truncated
 
 cdef class Vect16ListIterator(object):
     cdef Vect16List _vl
@@ -73,13 +73,21 @@ from sage.structure.sage_object cimport SageObject
 include 'sage/ext/interrupt.pxi'
 
 cimport group16
+cimport group16mod
 
+from libc.stdint cimport uint64_t
 from libcpp.vector cimport vector as stl_vector
 from libcpp.string cimport string as stl_string
 from libcpp.list cimport list as stl_list
 
 from sage.groups.perm_gps.permgroup import PermutationGroup_generic as SagePG
 
+cdef _set_control(group16.EnumerationControl &ctl, max_results, timeout):
+    if max_results is not None:
+        ctl.max_results = max_results
+    if timeout is not None:
+        ctl.set_timeout_seconds(timeout)
+
 cdef class PermGroup16(SageObject):
     def __init__(self, gr):
         r"""
@@ -136,8 +144,33 @@ cdef class PermGroup16(SageObject):
         if not self._g.check_sgs():
             raise ValueError, "Incorrect strong genrating system"
 
-    cpdef Vect16List elements_of_depth(self, int depth):
+    cpdef sort_transversals(self, int depth, max_part=None):
         r"""
+        Reorder the strong generating set for the canonical tests of the
+        vectors of sum up to ``depth``, without changing the results.
+
+        EXAMPLES::
+
+            sage: import os; os.sys.path.insert(0,os.path.abspath('.')); import perm16mod
+            sage: G6 = PermutationGroup([[(3,5),(4,6)], [(1,2),(3,4),(5,6)], [(1,4,6),(2,3,5)]])
+            sage: G6cpp = perm16mod.PermGroup16(G6)
+            sage: l6 = list(G6cpp.elements_of_depth(10))
+            sage: G6cpp.sort_transversals(10)
+            sage: list(G6cpp.elements_of_depth(10)) == l6
+            True
+            sage: G6cpp._check_sgs()
+        """
+        cdef uint64_t mp = depth if max_part is None else max_part
+        sig_on()
+        with nogil:
+            self._g.sort_transversals(depth, mp)
+        sig_off()
+
+    cpdef Vect16List elements_of_depth(self, int depth, max_results=None, timeout=None):
+        r"""
+        The enumeration stops after ``max_results`` results or ``timeout``
+        seconds, the result being then marked as ``truncated``.
+
         EXAMPLES::
 
             sage: import os; os.sys.path.insert(0,os.path.abspath('.')); import perm16mod
@@ -162,17 +195,29 @@ cdef class PermGroup16(SageObject):
             280
             sage: all(len(x) == 6 for x in l6)
             True
+            sage: l6.truncated
+            False
+            sage: l6 = G6cpp.elements_of_depth(10, max_results=5)
+            sage: len(l6), l6.truncated
+            (5, True)
+            sage: G6cpp.elements_of_depth(10, timeout=0).truncated
+            True
         """
         cdef Vect16List res = Vect16List.__new__(Vect16List)
+        cdef group16.EnumerationControl ctl
+        _set_control(ctl, max_results, timeout)
         res.dom =  self.dom
         sig_on()
         with nogil:
-            res._l = self._g.elements_of_depth(depth)
+            res._l = self._g.elements_of_depth(depth, &ctl)
         sig_off()
+        res.truncated = ctl.truncated()
         return res
 
-    cpdef Vect16List elements_of_evaluation(self, Vect16 v):
+    cpdef Vect16List elements_of_evaluation(self, Vect16 v, max_results=None, timeout=None):
         r"""
+        Same as :meth:`elements_of_depth` for ``max_results`` and ``timeout``.
+
         EXAMPLES::
 
             sage: import os; os.sys.path.insert(0,os.path.abspath('.')); import perm16mod
@@ -200,13 +245,16 @@ cdef class PermGroup16(SageObject):
             ValueError: Evaluation should be of sum 6
         """
         cdef Vect16List res = Vect16List.__new__(Vect16List)
+        cdef group16.EnumerationControl ctl
         if sum(v) != len(self.dom):
             raise ValueError("Evaluation should be of sum %s"%len(self.dom))
+        _set_control(ctl, max_results, timeout)
         res.dom =  self.dom
         sig_on()
         with nogil:
-            res._l = self._g.elements_of_evaluation(v._p)
+            res._l = self._g.elements_of_evaluation(v._p, &ctl)
         sig_off()
+        res.truncated = ctl.truncated()
         return res
 
     cpdef bint is_canonical(self, Vect16 v):
@@ -259,6 +307,50 @@ cdef class PermGroup16(SageObject):
         res._p = self._g.canonical(v._p)
         return res
 
+    def canonical_array(self, a, out=None):
+        r"""
+        The canonical forms of the rows of the (n x N) array of bytes ``a``,
+        stored in ``out`` or in a new ``numpy`` array. The rows are shared
+        among the workers with the GIL released. The coordinate ``i`` is the
+        one of the ``i``-th point of the domain.
+
+        EXAMPLES::
+
+            sage: import os; os.sys.path.insert(0,os.path.abspath('.')); import perm16mod
+            sage: import numpy
+            sage: G6 = PermutationGroup([[(3,5),(4,6)], [(1,2),(3,4),(5,6)], [(1,4,6),(2,3,5)]])
+            sage: G6cpp = perm16mod.PermGroup16(G6)
+            sage: a = numpy.array([[7,1,0,2,0,3], [1,2,3,4,5,6]], dtype=numpy.uint8)
+            sage: G6cpp.canonical_array(a).tolist()
+            [[7, 1, 0, 3, 0, 2], [6, 5, 3, 4, 2, 1]]
+
+        TESTS::
+
+            sage: l6 = IntegerVectors(5, 6).list()
+            sage: res = G6cpp.canonical_array(numpy.array(l6, dtype=numpy.uint8))
+            sage: res.tolist() == [list(G6cpp.canonical(perm16mod.Vect16(v, G6cpp))) for v in l6]
+            True
+        """
+        return group16mod.canonical_array(self._g, a, out)
+
+    def is_canonical_array(self, a, out=None):
+        r"""
+        Whether the rows of the (n x N) array of bytes ``a`` are canonical,
+        as a ``numpy`` array of booleans or in ``out``. See
+        :meth:`canonical_array`.
+
+        EXAMPLES::
+
+            sage: import os; os.sys.path.insert(0,os.path.abspath('.')); import perm16mod
+            sage: import numpy
+            sage: G6 = PermutationGroup([[(3,5),(4,6)], [(1,2),(3,4),(5,6)], [(1,4,6),(2,3,5)]])
+            sage: G6cpp = perm16mod.PermGroup16(G6)
+            sage: a = numpy.array([[7,1,0,2,0,0], [7,1,0,2,0,3]], dtype=numpy.uint8)
+            sage: G6cpp.is_canonical_array(a).tolist()
+            [True, False]
+        """
+        return group16mod.is_canonical_array(self._g, a, out)
+
 cdef list defaultdom = range(1,17)
 
 cdef class Vect16(SageObject):
@@ -514,3 +606,91 @@ cdef class Vect16ListIterator(object):
         return self
 
 
+def enable_statistics(bint enable=True):
+    r"""
+    Enable or disable the gathering of statistics by the enumerations.
+
+    EXAMPLES::
+
+        sage: import os; os.sys.path.insert(0,os.path.abspath('.')); import perm16mod
+        sage: G6 = PermutationGroup([[(3,5),(4,6)], [(1,2),(3,4),(5,6)], [(1,4,6),(2,3,5)]])
+        sage: G6cpp = perm16mod.PermGroup16(G6)
+        sage: perm16mod.reset_statistics()
+        sage: perm16mod.enable_statistics()
+        sage: len(G6cpp.elements_of_depth(10))
+        280
+        sage: perm16mod.enable_statistics(False)
+        sage: st = perm16mod.statistics()
+        sage: st['nodes'][:4], st['accepted'][10]
+        ([1, 1, 4, 7], 280)
+        sage: st['canonical_tests'] == sum(st['accepted']) + sum(st['rejected'])
+        True
+    """
+    group16.statistics().enable(enable)
+
+def reset_statistics():
+    r"""
+    Reset the statistics gathered by the enumerations.
+    """
+    group16.statistics().reset()
+
+def statistics():
+    r"""
+    Return the statistics gathered by the enumerations as a dict.
+
+    The lists are histograms indexed by depth in the enumeration tree
+    (``nodes``, ``accepted``, ``rejected``), by level of the stabilizer chain
+    (``rejection_level``) or by size class, ``k`` for sizes in
+    `2^{k-1} .. 2^k-1` (``frontier_sizes``). ``probe_lengths`` is indexed by
+    the number of extra buckets probed by the set insertions. See
+    ``statistics.hpp``.
+    """
+    cdef group16.Statistics st = group16.statistics().collect()
+    return {'nodes': st.nodes, 'accepted': st.accepted, 'rejected': st.rejected,
+            'canonical_tests': st.canonical_tests,
+            'rejection_level': st.rejection_level,
+            'frontier_sizes': st.frontier_sizes,
+            'frontiers': st.frontiers, 'frontier_total': st.frontier_total,
+            'requests': st.requests, 'inserted': st.inserted,
+            'collisions': st.collisions, 'max_probe': st.max_probe,
+            'probe_lengths': st.probe_lengths,
+            'time': st.nanoseconds * 1e-9}
+
+
+def enable_trace(size_t capacity=1 << 16):
+    r"""
+    Start recording the timeline of the enumerations, keeping the last
+    ``capacity`` events of each thread. See :func:`write_trace`.
+
+    EXAMPLES::
+
+        sage: import os; os.sys.path.insert(0,os.path.abspath('.')); import perm16mod
+        sage: G6 = PermutationGroup([[(3,5),(4,6)], [(1,2),(3,4),(5,6)], [(1,4,6),(2,3,5)]])
+        sage: G6cpp = perm16mod.PermGroup16(G6)
+        sage: perm16mod.reset_trace()
+        sage: perm16mod.enable_trace()
+        sage: len(G6cpp.elements_of_depth(10))
+        280
+        sage: perm16mod.disable_trace()
+        sage: filename = tmp_filename(ext='.json')
+        sage: perm16mod.write_trace(filename)
+        sage: import json
+        sage: names = set(ev['name'] for ev in json.load(open(filename))['traceEvents'])
+        sage: 'enumeration' in names, 'subtree' in names
+        (True, True)
+    """
+    group16.tracer().enable(capacity)
+
+def disable_trace():
+    group16.tracer().disable()
+
+def reset_trace():
+    group16.tracer().reset()
+
+def write_trace(filename):
+    r"""
+    Write the recorded timeline as Chrome trace events, to be loaded in
+    ``chrome://tracing`` or ``https://ui.perfetto.dev``.
+    """
+    if not group16.tracer().write_json(filename):
+        raise IOError("Unable to write the trace to %s"%filename)
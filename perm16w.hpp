@@ -0,0 +1,210 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _PERM16W_HPP
+#define _PERM16W_HPP
+
+#include <cstdint>
+#include <x86intrin.h>
+#include <array>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <ostream>
+
+#include "config.h"
+#include "perm16.hpp"
+
+namespace IVMPG {
+
+using vect16w = std::array<uint16_t, 16> ;
+
+// Same as Vect16 but with 16 bits entries, allowing for depth and max_part
+// larger than 255. The entries are stored in two SSE registers.
+struct alignas(16) Vect16w
+{
+
+  static const constexpr size_t Size = 16;
+
+  union {
+    vect16w p;
+    __m128i v[2];  // entries 0..7 and 8..15
+  };
+
+  Vect16w() = default;
+  Vect16w(const Vect16w &x) { v[0] = x.v[0]; v[1] = x.v[1]; }
+  Vect16w(std::initializer_list<uint16_t> il) {
+    assert (il.size() <= Size);
+    std::copy(il.begin(), il.end(), this->p.begin());
+    for (uint64_t i = il.size(); i<Size; i++) this->p[i] = 0;
+  }
+  Vect16w &operator =(const Vect16w &x) {v[0] = x.v[0]; v[1] = x.v[1]; return *this;}
+
+  uint16_t operator[](uint64_t i) const { return p[i]; }
+  uint16_t &operator[](uint64_t i) { return p[i]; }
+
+  // Bit i is set if the entries i of *this and b are equal.
+  unsigned eq_mask(const Vect16w &b) const {
+    return unsigned(_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(v[0], b.v[0]),
+						      _mm_cmpeq_epi16(v[1], b.v[1]))));
+  }
+  // Bit i is set if the entries i of *this and b differ.
+  unsigned diff_mask(const Vect16w &b) const { return ~eq_mask(b) & 0xffff; }
+  // Bit i is set if the entry i of *this is smaller than the one of b.
+  unsigned lt_mask(const Vect16w &b) const {
+    const __m128i ge0 = _mm_cmpeq_epi16(_mm_max_epu16(v[0], b.v[0]), v[0]);
+    const __m128i ge1 = _mm_cmpeq_epi16(_mm_max_epu16(v[1], b.v[1]), v[1]);
+    return ~unsigned(_mm_movemask_epi8(_mm_packs_epi16(ge0, ge1))) & 0xffff;
+  }
+
+  uint64_t first_diff(const Vect16w &b, size_t bound = Size) const {
+    const unsigned diff = ~eq_mask(b) & ((1u << bound) - 1);
+    return diff ? __builtin_ctz(diff) : Size;
+  }
+
+  bool operator==(const Vect16w &b) const { return eq_mask(b) == 0xffff; }
+  bool operator!=(const Vect16w &b) const { return eq_mask(b) != 0xffff; }
+
+  bool operator < (const Vect16w &b) const {
+    const unsigned diff = ~eq_mask(b) & 0xffff;
+    return (diff & (-diff)) & lt_mask(b);
+  }
+
+  int less_partial(const Vect16w &b, int k) const {
+    uint64_t diff = first_diff(b, k);
+    return (diff == Size) ? 0 : int(p[diff]) - int(b[diff]);
+  }
+
+  // The permutation is applied through byte shuffles: the entry i of other
+  // gives the bytes 2*i and 2*i+1 to be fetched from the 32 bytes of *this.
+  Vect16w permuted(const Vect16w &other) const {
+    Vect16w res;
+    for (int h = 0; h < 2; h++) {
+      const __m128i dbl = _mm_add_epi16(other.v[h], other.v[h]);
+      const __m128i idx = _mm_or_si128(dbl, _mm_slli_epi16(
+                              _mm_add_epi16(dbl, _mm_set1_epi16(1)), 8));
+      // The bit 4 of the byte index selects the register.
+      res.v[h] = _mm_blendv_epi8(_mm_shuffle_epi8(v[0], idx),
+				 _mm_shuffle_epi8(v[1], idx),
+				 _mm_slli_epi16(idx, 3));
+    }
+    return res;
+  };
+
+  unsigned zero_mask() const {
+    const __m128i zero {0, 0};
+    return unsigned(_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(v[0], zero),
+						      _mm_cmpeq_epi16(v[1], zero))));
+  }
+
+  static uint64_t first_index(unsigned mask, int bnd) {
+    mask &= (1u << bnd) - 1;
+    return mask ? __builtin_ctz(mask) : Size;
+  }
+  static uint64_t last_index(unsigned mask, int bnd) {
+    mask &= (1u << bnd) - 1;
+    return mask ? 31 - __builtin_clz(mask) : Size;
+  }
+
+  uint64_t last_non_zero(int bnd=Size) const { return last_index(~zero_mask(), bnd); }
+  uint64_t first_non_zero(int bnd=Size) const { return first_index(~zero_mask(), bnd); }
+  uint64_t last_zero(int bnd=Size) const { return last_index(zero_mask(), bnd); }
+  uint64_t first_zero(int bnd=Size) const { return first_index(zero_mask(), bnd); }
+
+  bool is_revsorted(size_t begin = 0, size_t end = Size) const {
+    if (end <= begin + 1) return true;
+    const __m128i next0 = _mm_alignr_epi8(v[1], v[0], 2);
+    const __m128i next1 = _mm_srli_si128(v[1], 2);
+    const __m128i ge0 = _mm_cmpeq_epi16(_mm_max_epu16(v[0], next0), v[0]);
+    const __m128i ge1 = _mm_cmpeq_epi16(_mm_max_epu16(v[1], next1), v[1]);
+    const unsigned ge = unsigned(_mm_movemask_epi8(_mm_packs_epi16(ge0, ge1)));
+    const unsigned range = ((1u << (end - 1)) - 1) & ~((1u << begin) - 1);
+    return (ge & range) == range;
+  }
+
+  // Only used by canonical, not worth a sorting network.
+  Vect16w revsorted(size_t begin = 0, size_t end = Size) const {
+    Vect16w res = *this;
+    if (begin < end) std::sort(res.p.begin()+begin, res.p.begin()+end, std::greater<uint16_t>());
+    return res;
+  }
+
+  // Saturate the entries to 8 bits.
+  Vect16 narrow() const {
+    Vect16 res;
+    res.v = _mm_packus_epi16(v[0], v[1]);
+    return res;
+  }
+
+  bool is_permutation(const size_t k = Size) const {
+    // Entries larger than 255 are saturated and therefore not in 0..15
+    return narrow().is_permutation(k);
+  }
+
+};
+
+std::ostream & operator<<(std::ostream & stream, const Vect16w &term);
+
+struct Perm16w : public Vect16w {
+
+  using vect = Vect16w;
+
+  Perm16w() : Vect16w({0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15}) {};
+  Perm16w(std::initializer_list<uint16_t> il) {
+    assert (il.size() <= vect::Size);
+    std::copy(il.begin(), il.end(), this->p.begin());
+    for (uint64_t i = il.size(); i<vect::Size; i++) this->p[i] = i;
+  }
+  Perm16w operator*(const Perm16w&p) const { return permuted(p); }
+  static Perm16w one() { return {}; }
+  static Perm16w elementary_transposition(uint64_t i) {
+    assert (i < vect::Size);
+    Perm16w res {}; res[i]=i+1; res[i+1]=i; return res; }
+
+private:
+
+  Perm16w(const vect v) : vect(v) {};
+
+};
+
+
+static_assert(sizeof(Vect16w) == sizeof(Perm16w),
+	      "Vect16w and Perm16w have a different memory layout !");
+
+} // namespace IVMPG
+
+
+namespace std {
+
+  template<>
+  struct hash<IVMPG::Vect16w> {
+    size_t operator () (const IVMPG::Vect16w &ar) const {
+      // Same as for Vect16
+      uint64_t h = _mm_crc32_u64(0, _mm_extract_epi64(ar.v[0], 0));
+      h = _mm_crc32_u64(h, _mm_extract_epi64(ar.v[0], 1));
+      h = _mm_crc32_u64(h, _mm_extract_epi64(ar.v[1], 0));
+      return _mm_crc32_u64(h, _mm_extract_epi64(ar.v[1], 1));
+    }
+  };
+
+  template<>
+  struct less<IVMPG::Vect16w> {
+    bool operator () (const IVMPG::Vect16w &v1, const IVMPG::Vect16w &v2) const {
+      return v1 < v2;
+    }
+  };
+}
+
+#endif
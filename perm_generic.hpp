@@ -20,6 +20,7 @@
 #include <array>
 #include <cassert>
 #include <algorithm>
+#include <functional>
 #include <ostream>
 
 #include "config.h"
@@ -80,6 +81,17 @@ struct VectGeneric {
     return Size;
   }
 
+  bool is_revsorted(size_t begin = 0, size_t end = Size) const {
+    for (uint64_t i=begin+1; i<end; i++) if (p[i-1] < p[i]) return false;
+    return true;
+  }
+
+  VectGeneric revsorted(size_t begin = 0, size_t end = Size) const {
+    VectGeneric res = *this;
+    if (begin < end) std::sort(res.p.begin()+begin, res.p.begin()+end, std::greater<Expo>());
+    return res;
+  }
+
   bool is_permutation(const size_t k = Size) const {
     auto temp = this->p;
     std::sort(temp.begin(), temp.end());
@@ -108,7 +120,7 @@ struct PermGeneric : public VectGeneric<_Size, Expo> {
 
   using vect = VectGeneric<_Size, Expo>;
 
-  PermGeneric() { for (uint64_t i=0; i<=_Size; i++) this->p[i] = i; };
+  PermGeneric() { for (uint64_t i=0; i<_Size; i++) this->p[i] = i; };
   PermGeneric(std::initializer_list<Expo> il) {
     assert (il.size() <= vect::Size);
     std::copy(il.begin(), il.end(), this->p.begin());
@@ -131,14 +143,16 @@ private:
 
 namespace std {
 
-  template<>
   template < size_t Size, typename Expo >
   struct hash< IVMPG::VectGeneric<Size,Expo> > {
     size_t operator () (const IVMPG::VectGeneric<Size,Expo> &ar) const {
       size_t h = 0;
       for (size_t i=0; i<IVMPG::VectGeneric<Size,Expo>::Size; i++)
 	h = hash<Expo>()(ar[i]) + (h << 6) + (h << 16) - h;
-      return h;
+      // Mix the high bits into the low ones used by bounded_set
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccd;
+      return h ^ (h >> 33);
     }
   };
 
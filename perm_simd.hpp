@@ -0,0 +1,261 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _PERM_SIMD_HPP
+#define _PERM_SIMD_HPP
+
+#include <cstdint>
+#include <x86intrin.h>
+#include <array>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <ostream>
+
+#include "config.h"
+#include "perm16.hpp"
+
+namespace IVMPG {
+
+// Vectors of 32 or 64 bytes stored as 2 or 4 SSE registers. The masks and
+// permutations only use SSE, without any scalar loop. Their AVX2 and
+// AVX512BW/VBMI versions are used by the canonical test kernels compiled for
+// these levels (see group_kernels.cpp).
+template < size_t _Size >
+struct alignas(16) VectSIMD
+{
+  static_assert(_Size == 32 or _Size == 64, "VectSIMD only handles 32 or 64 entries");
+
+  static const constexpr size_t Size = _Size;
+  static const constexpr size_t Blocks = _Size / 16;
+
+  union {
+    std::array<uint8_t, Size> p;
+    __m128i v[Blocks];
+  };
+
+  VectSIMD() = default;
+  VectSIMD(const VectSIMD &x) { for (size_t k=0; k<Blocks; k++) v[k] = x.v[k]; }
+  VectSIMD(std::initializer_list<uint8_t> il) {
+    assert (il.size() <= Size);
+    std::copy(il.begin(), il.end(), this->p.begin());
+    for (uint64_t i = il.size(); i<Size; i++) this->p[i] = 0;
+  }
+  VectSIMD &operator =(const VectSIMD &x) {
+    for (size_t k=0; k<Blocks; k++) v[k] = x.v[k];
+    return *this;
+  }
+
+  uint8_t operator[](uint64_t i) const { return p[i]; }
+  uint8_t &operator[](uint64_t i) { return p[i]; }
+
+  static uint64_t low_bits(size_t bound) {
+    return bound >= 64 ? ~uint64_t(0) : (uint64_t(1) << bound) - 1;
+  }
+
+  // Bit i is set if the entries i of *this and b differ.
+  uint64_t diff_mask(const VectSIMD &b) const {
+    uint64_t res = 0;
+    for (size_t k=0; k<Blocks; k++)
+      res |= uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v[k], b.v[k])))) << (16*k);
+    return ~res & low_bits(Size);
+  }
+  // Bit i is set if the entry i of *this is smaller than the one of b.
+  uint64_t lt_mask(const VectSIMD &b) const {
+    uint64_t res = 0;
+    for (size_t k=0; k<Blocks; k++)
+      res |= uint64_t(unsigned(_mm_movemask_epi8(
+               _mm_cmpeq_epi8(_mm_max_epu8(v[k], b.v[k]), v[k])))) << (16*k);
+    return ~res & low_bits(Size);
+  }
+  uint64_t zero_mask() const {
+    const __m128i zero {0, 0};
+    uint64_t res = 0;
+    for (size_t k=0; k<Blocks; k++)
+      res |= uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v[k], zero)))) << (16*k);
+    return res;
+  }
+
+  uint64_t first_diff(const VectSIMD &b, size_t bound = Size) const {
+    const uint64_t diff = diff_mask(b) & low_bits(bound);
+    return diff ? __builtin_ctzll(diff) : Size;
+  }
+
+  bool operator==(const VectSIMD &b) const { return diff_mask(b) == 0; }
+  bool operator!=(const VectSIMD &b) const { return diff_mask(b) != 0; }
+
+  bool operator < (const VectSIMD &b) const {
+    const uint64_t diff = diff_mask(b);
+    return (diff & (-diff)) & lt_mask(b);
+  }
+
+  char less_partial(const VectSIMD &b, int k) const {
+    uint64_t diff = first_diff(b, k);
+    return (diff == Size) ? 0 : char(p[diff]) - char(b[diff]);
+  }
+
+  // The low 4 bits of the index select the byte inside each register, the
+  // next bits select the register.
+  VectSIMD permuted(const VectSIMD &other) const {
+    VectSIMD res;
+    for (size_t h=0; h<Blocks; h++) {
+      const __m128i idx = other.v[h];
+      __m128i sel[Blocks];
+      for (size_t k=0; k<Blocks; k++) sel[k] = _mm_shuffle_epi8(v[k], idx);
+      for (size_t k=0; k<Blocks/2; k++)   // bit 4 moved to the sign bit
+        sel[k] = _mm_blendv_epi8(sel[2*k], sel[2*k+1], _mm_slli_epi16(idx, 3));
+      if (Blocks == 4)                    // bit 5 moved to the sign bit
+        sel[0] = _mm_blendv_epi8(sel[0], sel[1], _mm_slli_epi16(idx, 2));
+      res.v[h] = sel[0];
+    }
+    return res;
+  };
+
+  uint64_t first_non_zero(size_t bnd=Size) const {
+    const uint64_t m = ~zero_mask() & low_bits(bnd);
+    return m ? __builtin_ctzll(m) : Size;
+  }
+  uint64_t first_zero(size_t bnd=Size) const {
+    const uint64_t m = zero_mask() & low_bits(bnd);
+    return m ? __builtin_ctzll(m) : Size;
+  }
+  // Same default bound as VectGeneric
+  uint64_t last_non_zero(size_t bnd=16) const {
+    const uint64_t m = ~zero_mask() & low_bits(bnd);
+    return m ? 63 - __builtin_clzll(m) : Size;
+  }
+  uint64_t last_zero(size_t bnd=16) const {
+    const uint64_t m = zero_mask() & low_bits(bnd);
+    return m ? 63 - __builtin_clzll(m) : Size;
+  }
+
+  bool is_revsorted(size_t begin = 0, size_t end = Size) const {
+    if (end <= begin + 1) return true;
+    uint64_t ge = 0;
+    for (size_t k=0; k<Blocks; k++) {
+      const __m128i next = (k+1 < Blocks) ? _mm_alignr_epi8(v[k+1], v[k], 1)
+	                                  : _mm_srli_si128(v[k], 1);
+      ge |= uint64_t(unsigned(_mm_movemask_epi8(
+              _mm_cmpeq_epi8(_mm_max_epu8(v[k], next), v[k])))) << (16*k);
+    }
+    const uint64_t range = low_bits(end - 1) & ~low_bits(begin);
+    return (ge & range) == range;
+  }
+
+  // Only used by canonical, not worth a sorting network.
+  VectSIMD revsorted(size_t begin = 0, size_t end = Size) const {
+    VectSIMD res = *this;
+    if (begin < end) std::sort(res.p.begin()+begin, res.p.begin()+end, std::greater<uint8_t>());
+    return res;
+  }
+
+  static VectSIMD identity() {
+    VectSIMD res;
+    for (uint64_t i=0; i<Size; i++) res.p[i] = i;
+    return res;
+  }
+
+  bool is_permutation(const size_t k = Size) const {
+    const VectSIMD id = identity();
+    // every value should be reached and the entries from k on should be fixed
+    uint64_t reached = 0;
+    for (size_t i=0; i<Size; i++) {
+      const __m128i val = _mm_set1_epi8(i);
+      __m128i found = _mm_cmpeq_epi8(v[0], val);
+      for (size_t b=1; b<Blocks; b++) found = _mm_or_si128(found, _mm_cmpeq_epi8(v[b], val));
+      reached |= uint64_t(_mm_movemask_epi8(found) != 0) << i;
+    }
+    return reached == low_bits(Size) and (diff_mask(id) & ~low_bits(k)) == 0;
+  }
+
+};
+
+
+template < size_t Size >
+std::ostream & operator<<(std::ostream & stream, const VectSIMD<Size> &term) {
+  stream << "[" << unsigned(term[0]);
+  for (unsigned i=1; i < Size; i++) stream << "," << unsigned(term[i]);
+  stream << "]";
+  return stream;
+}
+
+// Definition since previously *only* declared
+template < size_t _Size >
+const constexpr size_t VectSIMD<_Size>::Size;
+template < size_t _Size >
+const constexpr size_t VectSIMD<_Size>::Blocks;
+
+
+template < size_t _Size >
+struct PermSIMD : public VectSIMD<_Size> {
+
+  using vect = VectSIMD<_Size>;
+
+  PermSIMD() : vect(vect::identity()) {};
+  PermSIMD(std::initializer_list<uint8_t> il) {
+    assert (il.size() <= vect::Size);
+    std::copy(il.begin(), il.end(), this->p.begin());
+    for (uint64_t i = il.size(); i<vect::Size; i++) this->p[i] = i;
+  }
+  PermSIMD operator*(const PermSIMD&p) const { return this->permuted(p); }
+  static PermSIMD one() { return {}; }
+  static PermSIMD elementary_transposition(uint64_t i) {
+    assert (i < vect::Size);
+    PermSIMD res {}; res[i]=i+1; res[i+1]=i; return res; }
+
+private:
+
+  PermSIMD(const vect v) : vect(v) {};
+
+};
+
+using Vect32 = VectSIMD<32>;
+using Perm32 = PermSIMD<32>;
+using Vect64 = VectSIMD<64>;
+using Perm64 = PermSIMD<64>;
+
+static_assert(sizeof(Vect32) == sizeof(Perm32),
+	      "Vect32 and Perm32 have a different memory layout !");
+static_assert(sizeof(Vect64) == sizeof(Perm64),
+	      "Vect64 and Perm64 have a different memory layout !");
+
+} // namespace IVMPG
+
+
+namespace std {
+
+  template < size_t Size >
+  struct hash< IVMPG::VectSIMD<Size> > {
+    size_t operator () (const IVMPG::VectSIMD<Size> &ar) const {
+      // Same as for Vect16
+      uint64_t h = 0;
+      for (size_t k=0; k<IVMPG::VectSIMD<Size>::Blocks; k++) {
+	h = _mm_crc32_u64(h, _mm_extract_epi64(ar.v[k], 0));
+	h = _mm_crc32_u64(h, _mm_extract_epi64(ar.v[k], 1));
+      }
+      return h;
+    }
+  };
+
+  template < size_t Size >
+  struct less< IVMPG::VectSIMD<Size> > {
+    bool operator () (const IVMPG::VectSIMD<Size> &v1, const IVMPG::VectSIMD<Size> &v2) const {
+      return v1 < v2;
+    }
+  };
+
+}
+
+#endif
@@ -75,11 +75,17 @@ struct Fixture : public IsPermFunctions<typename PermType::vect> {
 
 //____________________________________________________________________________//
 
+#include <set>
 #include "perm16.hpp"
+#include "perm16w.hpp"
+#include "perm_simd.hpp"
 #include "perm_generic.hpp"
 
 typedef boost::mpl::list<
   Fixture< IVMPG::Perm16 >,
+  Fixture< IVMPG::Perm16w >,
+  Fixture< IVMPG::Perm32 >,
+  Fixture< IVMPG::Perm64 >,
   Fixture< IVMPG::PermGeneric<16> >,
   Fixture< IVMPG::PermGeneric<32> >
 > Fixtures;
@@ -91,7 +97,7 @@ BOOST_AUTO_TEST_SUITE( VectType_test )
 
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( sizeof_test, F, Fixtures, F )
 {
-  BOOST_CHECK_EQUAL( sizeof(F::zero), F::VectType::Size );
+  BOOST_CHECK_EQUAL( sizeof(F::zero), F::VectType::Size * sizeof(F::zero[0]) );
 }
 
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( equal_test, F, Fixtures, F )
@@ -227,6 +233,42 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( last_non_zero_test, F, Fixtures, F )
   BOOST_CHECK_EQUAL( F::PPa.last_non_zero(3), 2u);
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( is_revsorted_test, F, Fixtures, F )
+{
+  BOOST_CHECK( F::zero.is_revsorted() );
+  BOOST_CHECK( F::P10.is_revsorted() );
+  BOOST_CHECK( not F::P01.is_revsorted() );
+  BOOST_CHECK( F::P01.is_revsorted(1) );
+  BOOST_CHECK( F::P01.is_revsorted(0, 1) );
+  BOOST_CHECK( not F::P01.is_revsorted(0, 2) );
+  BOOST_CHECK( F::P11.is_revsorted() );
+  BOOST_CHECK( not F::PPa.is_revsorted() );
+  BOOST_CHECK( not F::PPa.is_revsorted(4, 6) );
+  BOOST_CHECK( F::PPa.is_revsorted(3, 5) );
+  BOOST_CHECK( F::RandPerm.is_revsorted(4, 7) );
+  BOOST_CHECK( not F::RandPerm.is_revsorted(3, 6) );
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( revsorted_test, F, Fixtures, F )
+{
+  using V = typename F::VectType;
+  BOOST_CHECK_EQUAL( F::zero.revsorted(), F::zero );
+  BOOST_CHECK_EQUAL( F::P01.revsorted(), F::P10 );
+  BOOST_CHECK_EQUAL( F::P01.revsorted(0, 1), F::P01 );
+  BOOST_CHECK_EQUAL( F::P01.revsorted(1), F::P01 );
+  BOOST_CHECK_EQUAL( F::PPa.revsorted(0, 5), F::completePerm(V({4,3,2,1,0,5,6,7,8,9,10,11,12,13,14,15})) );
+  BOOST_CHECK_EQUAL( F::PPa.revsorted(2, 5), F::completePerm(V({1,2,4,3,0,5,6,7,8,9,10,11,12,13,14,15})) );
+  BOOST_CHECK_EQUAL( F::RandPerm.revsorted(6, 12),
+		     F::completePerm(V({3,1,0,14,15,13,12,11,10,6,5,2,7,4,8,9})) );
+  BOOST_CHECK_EQUAL( V({1,0,2,255,3,0,0,0,0,0,0,0,0,0,0,0}).revsorted(1, 5),
+		     V({1,255,3,2,0}) );
+  for (auto it = F::Plist.begin(); it != F::Plist.end(); ++it) {
+    BOOST_CHECK( it->revsorted().is_revsorted() );
+    for (size_t k = 0; k < 16; k++)
+      BOOST_CHECK( it->revsorted(k, 16).is_revsorted(k, 16) );
+  }
+}
+
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( permuted_test, F, Fixtures, F )
 {
   BOOST_CHECK_EQUAL( F::zero.permuted(F::zero), F::zero );
@@ -263,6 +305,19 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( operator_insert_test, F, Fixtures, F )
   BOOST_CHECK_EQUAL(out.str(), out2.str());
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE( hash_low_bits_test, F, Fixtures, F )
+{
+  // Vectors supported on the first 4 entries, hashed into 1024 buckets.
+  // A random function would reach about 737 of them.
+  std::set<size_t> buckets;
+  typename F::VectType v = F::zero;
+  for (unsigned i = 0; i < 6*6*6*6; i++) {
+    for (unsigned j = 0, k = i; j < 4; j++, k /= 6) v[j] = k % 6;
+    buckets.insert(std::hash<typename F::VectType>()(v) & 1023);
+  }
+  BOOST_CHECK_GE( buckets.size(), 600u );
+}
+
 BOOST_FIXTURE_TEST_CASE_TEMPLATE( is_permutation_test, F, Fixtures, F )
 {
   BOOST_CHECK_PREDICATE(F::is_not_perm, (F::zero));
@@ -279,6 +334,62 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE( is_permutation_test, F, Fixtures, F )
 BOOST_AUTO_TEST_SUITE_END()
 
 
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_SUITE( large_vect_test )
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE( wide_entries_test )
+{
+  using V = IVMPG::Vect16w;
+  // 300 and 44 have the same lower byte
+  const V a {1, 300, 2}, b {1, 44, 2}, c {1, 300, 3};
+  BOOST_CHECK_NE( a, b );
+  BOOST_CHECK_EQUAL( a.first_diff(b), 1u );
+  BOOST_CHECK_EQUAL( a.first_diff(c), 2u );
+  BOOST_CHECK_EQUAL( a.first_diff(c, 2), V::Size );
+  BOOST_CHECK( b < a );
+  BOOST_CHECK( not (a < b) );
+  BOOST_CHECK( a < c );
+  BOOST_CHECK_GT( a.less_partial(b, 2), 0 );
+  BOOST_CHECK_EQUAL( V({0, 0, 0, 256}).last_non_zero(), 3u );
+  BOOST_CHECK_EQUAL( V({0, 0, 0, 256}).first_non_zero(), 3u );
+  BOOST_CHECK( not V({0, 1, 258, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}).is_permutation() );
+  BOOST_CHECK_EQUAL( a.permuted(IVMPG::Perm16w({2, 0, 1})), V({2, 1, 300}) );
+  BOOST_CHECK_EQUAL( V({0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1000}).permuted(
+                       IVMPG::Perm16w({15, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0})),
+                     V({1000}) );
+  BOOST_CHECK( V({1000, 999, 300, 44}).is_revsorted() );
+  BOOST_CHECK( not V({1000, 999, 44, 300}).is_revsorted() );
+  BOOST_CHECK_EQUAL( a.narrow(), IVMPG::Vect16({1, 255, 2}) );
+}
+
+BOOST_AUTO_TEST_CASE( large_entries_test )
+{
+  using V = IVMPG::Vect64;
+  using P = IVMPG::Perm64;
+  V a {}, b {};
+  a[40] = 3; b[40] = 3; b[63] = 1;
+  BOOST_CHECK_EQUAL( a.first_diff(b), 63u );
+  BOOST_CHECK_EQUAL( a.first_diff(b, 63), V::Size );
+  BOOST_CHECK( a < b );
+  BOOST_CHECK_EQUAL( a.last_non_zero(V::Size), 40u );
+  BOOST_CHECK_EQUAL( b.last_non_zero(V::Size), 63u );
+  BOOST_CHECK_EQUAL( b.first_non_zero(), 40u );
+  BOOST_CHECK_EQUAL( b.last_non_zero(50), 40u );
+  P rot;
+  for (size_t i=0; i<V::Size; i++) rot[i] = (i+1) % V::Size;
+  BOOST_CHECK( rot.is_permutation() );
+  BOOST_CHECK( not rot.is_permutation(63) );
+  V c = b;
+  for (size_t i=0; i<V::Size; i++) c = c.permuted(rot);
+  BOOST_CHECK_EQUAL( c, b );
+  BOOST_CHECK_EQUAL( b.permuted(rot)[62], 1u );
+  BOOST_CHECK_EQUAL( b.permuted(rot)[39], 3u );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 
 //____________________________________________________________________________//
 //____________________________________________________________________________//
@@ -306,6 +417,9 @@ struct PermFixture : public IsPermFunctions<_Perm> {
 
 typedef boost::mpl::list<
   PermFixture< IVMPG::Perm16 >,
+  PermFixture< IVMPG::Perm16w >,
+  PermFixture< IVMPG::Perm32 >,
+  PermFixture< IVMPG::Perm64 >,
   PermFixture< IVMPG::PermGeneric<16> >,
   PermFixture< IVMPG::PermGeneric<32> >
 > PermFixtures;
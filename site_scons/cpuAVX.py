@@ -80,4 +80,13 @@ def CheckGCCVectorExtension(context):
     context.Result(result)
     return result
 
+def CheckCXXFlags(context, flags):
+    context.Message('Checking compiler for %s... '%' '.join(flags))
+    save_flags = context.env['CXXFLAGS']
+    context.env.Append(CXXFLAGS = flags)
+    result = context.TryCompile("int main() { return 0; }\n", '.cpp')
+    context.env.Replace(CXXFLAGS = save_flags)
+    context.Result(result)
+    return result
+
 Tests = { key : val for key, val in globals().items() if key.startswith('Check') }
@@ -0,0 +1,173 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _STATISTICS_HPP
+#define _STATISTICS_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <ostream>
+#include <string>
+
+namespace IVMPG {
+
+// Statistics of the enumerations, gathered when enabled at runtime. They
+// replace the compile time SET_STATISTIC and SET_SIZE_STATISTIC counters of
+// bounded_set and of the canonical test. Each thread updates its own
+// counters, which are summed by collect. The vectors
+// are histograms indexed by depth in the enumeration tree, by level in the
+// stabilizer chain or by size class (k for sizes in 2^(k-1)..2^k-1).
+struct Statistics {
+
+  std::vector<uint64_t> nodes;      // internal nodes of the tree per depth
+  std::vector<uint64_t> accepted;   // canonical children per depth
+  std::vector<uint64_t> rejected;   // non canonical children per depth
+  // Canonical test
+  uint64_t canonical_tests = 0;
+  std::vector<uint64_t> rejection_level;  // level rejecting, sym_tail for the tail
+  std::vector<uint64_t> frontier_sizes;   // size classes of the frontier sets
+  uint64_t frontiers = 0, frontier_total = 0;  // number of sets and sum of their sizes
+  // Sets
+  uint64_t requests = 0;    // calls to bounded_set::insert
+  uint64_t inserted = 0;    // keys which were not in the set
+  uint64_t collisions = 0;  // extra buckets probed
+  uint64_t max_probe = 0;
+  std::vector<uint64_t> probe_lengths;
+  // Wall clock time of the enumerations
+  uint64_t nanoseconds = 0;
+
+  static size_t size_class(uint64_t n) { return n ? 64 - __builtin_clzll(n) : 0; }
+  static void add(std::vector<uint64_t> &hist, size_t i, uint64_t n = 1) {
+    if (hist.size() <= i) hist.resize(i+1);
+    hist[i] += n;
+  }
+
+  void record_insert(uint64_t probe, bool new_key) {
+    requests++;
+    inserted += new_key;
+    collisions += probe;
+    if (probe > max_probe) max_probe = probe;
+    add(probe_lengths, probe);
+  }
+  void record_frontier(uint64_t size) {
+    frontiers++;
+    frontier_total += size;
+    add(frontier_sizes, size_class(size));
+  }
+  void record_canonical(bool res, uint64_t level) {
+    canonical_tests++;
+    if (not res) add(rejection_level, level);
+  }
+
+  void merge(const Statistics &other);
+};
+
+inline void Statistics::merge(const Statistics &other) {
+  for (auto h : {std::make_pair(&nodes, &other.nodes),
+	         std::make_pair(&accepted, &other.accepted),
+	         std::make_pair(&rejected, &other.rejected),
+	         std::make_pair(&rejection_level, &other.rejection_level),
+	         std::make_pair(&frontier_sizes, &other.frontier_sizes),
+	         std::make_pair(&probe_lengths, &other.probe_lengths)})
+    for (size_t i=0; i<h.second->size(); i++) add(*h.first, i, (*h.second)[i]);
+  canonical_tests += other.canonical_tests;
+  frontiers += other.frontiers;
+  frontier_total += other.frontier_total;
+  requests += other.requests;
+  inserted += other.inserted;
+  collisions += other.collisions;
+  if (other.max_probe > max_probe) max_probe = other.max_probe;
+  nanoseconds += other.nanoseconds;
+}
+
+// The counters of all the threads. They are not synchronized: collect and
+// reset are meant to be called when no enumeration is running. The registry
+// is a lock free list, constant initialized and never destroyed, so that no
+// code runs for it at load time nor at exit.
+class StatisticsRegistry {
+
+  struct Node {
+    Statistics stats;
+    Node *next;
+  };
+  std::atomic<bool> enabled {false};
+  std::atomic<Node *> head {nullptr};
+
+  Statistics &register_thread() {
+    Node *node = new Node {Statistics(), head.load(std::memory_order_relaxed)};
+    while (not head.compare_exchange_weak(node->next, node, std::memory_order_release)) {}
+    return node->stats;
+  }
+
+public:
+
+  constexpr StatisticsRegistry() {}
+
+  bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+  void enable(bool b = true) { enabled.store(b, std::memory_order_relaxed); }
+
+  // Counters of the calling thread
+  Statistics &local() {
+    static thread_local Statistics *stats = nullptr;
+    if (not stats) stats = &register_thread();
+    return *stats;
+  }
+
+  Statistics collect() const {
+    Statistics res;
+    for (Node *n = head.load(std::memory_order_acquire); n; n = n->next) res.merge(n->stats);
+    return res;
+  }
+  void reset() {
+    for (Node *n = head.load(std::memory_order_acquire); n; n = n->next) n->stats = Statistics();
+  }
+};
+
+// Allows for a single instance in a header only library
+template <class Dummy = void>
+struct StatisticsHolder { static StatisticsRegistry registry; };
+template <class Dummy>
+StatisticsRegistry StatisticsHolder<Dummy>::registry;
+
+inline StatisticsRegistry &statistics() { return StatisticsHolder<>::registry; }
+
+inline std::string histogram_string(const std::vector<uint64_t> &hist) {
+  std::string res = "[";
+  for (size_t i=0; i<hist.size(); i++) res += (i ? ", " : "") + std::to_string(hist[i]);
+  return res + "]";
+}
+
+inline std::ostream & operator<<(std::ostream & stream, const Statistics &st) {
+  const double requests = st.requests, frontiers = st.frontiers;
+  stream << "Nodes per depth = " << histogram_string(st.nodes)
+	 << "\nAccepted per depth = " << histogram_string(st.accepted)
+	 << "\nRejected per depth = " << histogram_string(st.rejected)
+	 << "\nCanonical tests = " << st.canonical_tests
+	 << ", rejections per level = " << histogram_string(st.rejection_level)
+	 << "\nFrontier sets = " << st.frontiers
+	 << ", mean size = " << (frontiers ? st.frontier_total / frontiers : 0)
+	 << ", size classes = " << histogram_string(st.frontier_sizes)
+	 << "\nInsert requests = " << st.requests << ", new keys = " << st.inserted
+	 << ", collisions per request = " << (requests ? st.collisions / requests : 0)
+	 << ", max probe = " << st.max_probe
+	 << ", probe lengths = " << histogram_string(st.probe_lengths)
+	 << "\nTime = " << st.nanoseconds * 1e-9 << "s";
+  return stream;
+}
+
+} //  namespace IVMPG
+
+#endif // _STATISTICS_HPP
@@ -18,12 +18,42 @@
 
 #ifdef USE_CILK
 
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <sched.h>
 #include <cilk/cilk.h>
 #include <cilk/cilk_api.h>
 #include <cilk/holder.h>
 
 namespace IVMPG {
 
+// Whether the workers are pinned on a core when they first get their storage.
+// Off by default, set the environment variable IVMPG_PIN_WORKERS to enable.
+inline std::atomic<bool> &pin_workers() {
+  static std::atomic<bool> pin {std::getenv("IVMPG_PIN_WORKERS") != nullptr};
+  return pin;
+}
+
+// Pin the calling thread on the n-th (modulo) core the process may run on.
+inline bool pin_current_thread(size_t n) {
+  static const cpu_set_t allowed = [] {
+    cpu_set_t set; CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+    return set;
+  }();
+  const size_t ncpus = CPU_COUNT(&allowed);
+  if (ncpus == 0) return false;
+  n %= ncpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &allowed) and n-- == 0) {
+      cpu_set_t set; CPU_ZERO(&set); CPU_SET(cpu, &set);
+      return sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+  }
+  return false;
+}
+
 template<class T>
 class Storage_holder {
   cilk::holder< T > store;
@@ -33,15 +63,35 @@ public:
 
 template<class T>
 class Storage_thread_local {
-  // We ensure that T are aligned on cache line boundary to prevent false sharing.
-  struct alignas(256) PaddedT {
-    T t;
+  // Each worker builds its own T on first use so that the memory T allocates
+  // is first touched, hence physically allocated, on the worker's NUMA node.
+  // The slots are padded to a few cache lines to prevent false sharing.
+  struct Slot {
+    std::unique_ptr<T> t;
+    char padding[256 - sizeof(std::unique_ptr<T>)];
   };
-  PaddedT *store;
+  const size_t nworkers;
+  std::unique_ptr<Slot[]> store;
+
+  T &make_store(Slot &slot, size_t worker) {
+    if (pin_workers().load(std::memory_order_relaxed)) pin_current_thread(worker);
+    slot.t.reset(new T());
+    return *slot.t;
+  }
+
 public:
-  Storage_thread_local() : store(new PaddedT[__cilkrts_get_nworkers()]) { };
-  ~Storage_thread_local() { delete [] store; }
-  T &get_store() { return store[__cilkrts_get_worker_number()].t; }
+  Storage_thread_local() :
+    nworkers(__cilkrts_get_nworkers()), store(new Slot[nworkers]) { };
+  T &get_store() {
+    const size_t worker = __cilkrts_get_worker_number();
+    Slot &slot = store[worker];
+    return slot.t ? *slot.t : make_store(slot, worker);
+  }
+  // Apply f to the storage of each worker having used it. Not thread safe.
+  template<class F>
+  void for_each(F f) {
+    for (size_t i=0; i<nworkers; i++) if (store[i].t) f(*store[i].t);
+  }
 };
 
 } // namespace IVMPG
@@ -55,6 +105,8 @@ class Storage_dummy {
   T store;
 public:
   T &get_store() { return store; }
+  template<class F>
+  void for_each(F f) { f(store); }
 };
 
 } // namespace IVMPG 
@@ -18,6 +18,8 @@
 #include <cassert>
 
 #include "perm_generic.hpp"
+#include "perm16w.hpp"
+#include "perm_simd.hpp"
 #include "group16.hpp"
 #include "group_examples.hpp"
 
@@ -76,6 +78,9 @@ void do_timing(std::string name) {
 
 int main() {
   do_timing< PermutationGroup16 >("Fast");
+  do_timing< PermutationGroup< Perm16w > >("Wide 16");
+  do_timing< PermutationGroup< Perm32 > >("SIMD 32");
+  do_timing< PermutationGroup< Perm64 > >("SIMD 64");
   do_timing< PermutationGroup< PermGeneric<16> > >("Generic 16");
   do_timing< PermutationGroup< PermGeneric<32> > >("Generic 32");
 }
@@ -0,0 +1,261 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+// Microbenchmarks of the Vect16/Perm16 primitives and of the canonical test.
+//
+// Every primitive runs over a fixed corpus of random vectors and the result is
+// given in ns per operation. The throughput is measured on independent
+// operations, the latency on a chain where each operation depends on the
+// result of the previous one. The canonical test is measured for each
+// instruction set level supported by the processor.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "config.h"
+#include "group16.hpp"
+#include "group_examples.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace IVMPG;
+
+using MyGroup = PermutationGroup16;
+
+static const size_t corpus_size = 4096;     // power of 2
+static const size_t ops = 1 << 24;          // operations per measure
+
+static mt19937_64 rng(42);
+static volatile uint64_t sink;
+
+template <class Fun>
+static double time_ns(size_t nops, Fun fun) {
+  fun(nops / 16);  // warm up
+  auto tstart = high_resolution_clock::now();
+  sink = fun(nops);
+  auto tfin = high_resolution_clock::now();
+  return duration_cast<duration<double, nano>>(tfin - tstart).count() / nops;
+}
+
+static void report(string name, double ns) {
+  cout << "  " << left << setw(44) << name << right << fixed
+       << setprecision(3) << setw(9) << ns << " ns/op"
+       << setprecision(1) << setw(9) << 1e3 / ns << " Mop/s" << endl;
+}
+
+// Random entries in 0..max_value on the first n coordinates
+static vector<Vect16> random_vects(size_t n, unsigned max_value) {
+  uniform_int_distribution<unsigned> dist(0, max_value);
+  vector<Vect16> res(corpus_size);
+  for (auto &v : res) {
+    v = {};
+    for (size_t i = 0; i < n; i++) v[i] = dist(rng);
+  }
+  return res;
+}
+
+static vector<Perm16> random_perms() {
+  vector<Perm16> res(corpus_size);
+  for (auto &p : res) shuffle(p.p.begin(), p.p.end(), rng);
+  return res;
+}
+
+// Copies of the vectors of a, first differing at a uniform position (16 means equal)
+static vector<Vect16> differ_at_random(const vector<Vect16> &a) {
+  uniform_int_distribution<unsigned> dist(0, 16);
+  vector<Vect16> res(a);
+  for (auto &v : res) {
+    size_t i = dist(rng);
+    if (i < 16) v[i] ^= 1 + (rng() % 255);
+  }
+  return res;
+}
+
+// Alternatives to the pcmpestri based primitives
+static uint64_t first_diff_movemask(const Vect16 &a, const Vect16 &b, size_t bound = 16) {
+  const unsigned diff =
+    ~unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(a.v, b.v))) & ((1u << bound) - 1);
+  return diff ? __builtin_ctz(diff) : 16;
+}
+static uint64_t last_non_zero_movemask(const Vect16 &a, int bound = 16) {
+  const __m128i zero {0, 0};
+  const unsigned nz =
+    ~unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(a.v, zero))) & ((1u << bound) - 1);
+  return nz ? 31 - __builtin_clz(nz) : 16;
+}
+
+static const size_t mask = corpus_size - 1;
+
+// Make v depend on the result of the previous operation for the latency
+// measures. This adds the latency of a movq and a paddb (about 3 cycles).
+static Vect16 depend(Vect16 v, uint64_t prev) {
+  v.v = _mm_add_epi8(v.v, _mm_cvtsi64_si128(prev));
+  return v;
+}
+
+static void time_first_diff() {
+  const auto a = random_vects(16, 255), b = differ_at_random(a);
+  cout << "first_diff (uniform first difference):" << endl;
+  report("cmpestri throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += a[i & mask].first_diff(b[i & mask]);
+	return res; }));
+  report("movemask+tzcnt throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += first_diff_movemask(a[i & mask], b[i & mask]);
+	return res; }));
+  report("cmpestri latency", time_ns(ops, [&](size_t n) {
+	uint64_t j = 0;
+	for (size_t i = 0; i < n; i++) j = depend(a[i & mask], j).first_diff(b[i & mask]);
+	return j; }));
+  report("movemask+tzcnt latency", time_ns(ops, [&](size_t n) {
+	uint64_t j = 0;
+	for (size_t i = 0; i < n; i++) j = first_diff_movemask(depend(a[i & mask], j), b[i & mask]);
+	return j; }));
+  report("cmpestri bound 8 throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += a[i & mask].first_diff(b[i & mask], 8);
+	return res; }));
+  report("movemask+tzcnt bound 8 throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += first_diff_movemask(a[i & mask], b[i & mask], 8);
+	return res; }));
+}
+
+static void time_last_non_zero() {
+  // Vectors whose support is a random prefix, as in the enumeration tree
+  auto a = random_vects(16, 3);
+  for (auto &v : a) for (size_t i = rng() % 17; i < 16; i++) v[i] = 0;
+  cout << "last_non_zero:" << endl;
+  report("cmpestri throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += a[i & mask].last_non_zero();
+	return res; }));
+  report("movemask+lzcnt throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += last_non_zero_movemask(a[i & mask]);
+	return res; }));
+  report("cmpestri latency", time_ns(ops, [&](size_t n) {
+	uint64_t j = 0;
+	for (size_t i = 0; i < n; i++) j = depend(a[i & mask], j).last_non_zero();
+	return j; }));
+  report("movemask+lzcnt latency", time_ns(ops, [&](size_t n) {
+	uint64_t j = 0;
+	for (size_t i = 0; i < n; i++) j = last_non_zero_movemask(depend(a[i & mask], j));
+	return j; }));
+}
+
+static void time_vect_ops() {
+  const auto a = random_vects(16, 255), b = differ_at_random(a);
+  const auto p = random_perms();
+  cout << "Vect16 operations:" << endl;
+  report("permuted throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += a[i & mask].permuted(p[i & mask])[0];
+	return res; }));
+  report("permuted latency", time_ns(ops, [&](size_t n) {
+	Vect16 v = a[0];
+	for (size_t i = 0; i < n; i++) v = v.permuted(p[i & mask]);
+	return v[0]; }));
+  report("operator< throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += a[i & mask] < b[i & mask];
+	return res; }));
+  report("operator== throughput", time_ns(ops, [&](size_t n) {
+	uint64_t res = 0;
+	for (size_t i = 0; i < n; i++) res += a[i & mask] == b[i & mask];
+	return res; }));
+  for (size_t N : {16, 8}) {
+    const auto h = random_vects(N, 255);
+    report("hash throughput (N = " + to_string(N) + ")", time_ns(ops, [&](size_t n) {
+	  uint64_t res = 0;
+	  for (size_t i = 0; i < n; i++) res += hash<Vect16>()(h[i & mask]);
+	  return res; }));
+  }
+}
+
+static void time_bounded_set() {
+  cout << "bounded_set<Vect16>:" << endl;
+  for (size_t N : {16, 8}) {
+    const auto a = random_vects(N, 255);
+    for (size_t k : {16, 256}) {
+      set<Vect16> s;
+      const string params = " (N = " + to_string(N) + ", " + to_string(k) + " keys)";
+      report("insert+clear per key" + params, time_ns(ops, [&](size_t n) {
+	    size_t off = 0;
+	    for (size_t i = 0; i < n; i += k, off = (off + k) & mask) {
+	      for (size_t j = 0; j < k; j++) s.insert(a[(off + j) & mask]);
+	      s.clear();
+	    }
+	    return off; }));
+      s.clear();
+      for (size_t j = 0; j < k; j++) s.insert(a[j]);
+      report("insert existing key" + params, time_ns(ops, [&](size_t n) {
+	    for (size_t i = 0; i < n; i++) s.insert(a[i % k]);
+	    return 0; }));
+    }
+  }
+}
+
+// Corpus of canonical vectors of the given depth and of random reorderings
+// of them, which are mostly non canonical.
+static void time_canonical(const MyGroup &g, uint64_t depth) {
+  auto lst = g.elements_of_depth(depth);
+  vector<Vect16> canon(lst.begin(), lst.end());
+  if (canon.size() > corpus_size) canon.resize(corpus_size);
+  vector<Vect16> other(canon);
+  for (auto &v : other) shuffle(v.p.begin(), v.p.begin() + g.N, rng);
+  const size_t nops = ops / 64;
+  MyGroup::TemporaryStorage st;
+
+  cout << "is_canonical " << g.name << " (depth " << depth << ", "
+       << canon.size() << " vectors):" << endl;
+  for (ISA isa : {ISA::SSE4_2, ISA::AVX2, ISA::AVX512}) {
+    if (isa > cpu_isa()) break;
+    set_dispatch_isa(isa);
+    for (auto corpus : {&canon, &other}) {
+      const auto &c = *corpus;
+      report(string(isa_name(isa)) + (corpus == &canon ? " canonical" : " reordered"),
+	     time_ns(nops, [&](size_t n) {
+		 uint64_t res = 0;
+		 for (size_t i = 0; i < n; i++) res += g.is_canonical(c[i % c.size()], st);
+		 return res; }));
+    }
+  }
+  auto &stats = statistics();
+  stats.reset();
+  stats.enable();
+  for (const auto &v : canon) g.is_canonical(v, st);
+  for (const auto &v : other) g.is_canonical(v, st);
+  stats.enable(false);
+  cout << stats.collect() << endl;
+}
+
+int main() {
+  cout << "Processor instruction set: " << isa_name(cpu_isa()) << endl;
+  time_first_diff();
+  time_last_non_zero();
+  time_vect_ops();
+  time_bounded_set();
+  time_canonical(GroupExamples< MyGroup >::S3, 30);
+  time_canonical(GroupExamples< MyGroup >::S2xS4, 20);
+  time_canonical(GroupExamples< MyGroup >::g100, 20);
+  time_canonical(GroupExamples< MyGroup >::g_Borie, 15);
+}
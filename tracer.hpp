@@ -0,0 +1,265 @@
+/******************************************************************************/
+/*       Copyright (C) 2014 Florent Hivert <Florent.Hivert@lri.fr>,           */
+/*                                                                            */
+/*  Distributed under the terms of the GNU General Public License (GPL)       */
+/*                                                                            */
+/*    This code is distributed in the hope that it will be useful,            */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*   General Public License for more details.                                 */
+/*                                                                            */
+/*  The full text of the GPL is available at:                                 */
+/*                                                                            */
+/*                  http://www.gnu.org/licenses/                              */
+/******************************************************************************/
+
+#ifndef _TRACER_HPP
+#define _TRACER_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <ostream>
+#include <fstream>
+#include <iomanip>
+
+#ifdef USE_CILK
+#include <cilk/cilk_api.h>
+#endif
+
+namespace IVMPG {
+
+// Timeline of the parallel enumerations, written as Chrome trace events
+// (chrome://tracing or https://ui.perfetto.dev). Each thread records its
+// events in its own ring buffer, only while tracing is enabled; the oldest
+// events are overwritten when a buffer is full.
+struct TraceEvent {
+  static const constexpr size_t max_root = 32;
+
+  const char *name;
+  char phase;        // 'X' for a span, 'i' for an instant
+  uint32_t tid;      // thread which ran the span
+  uint64_t start, duration;  // nanoseconds since enable
+  uint32_t depth;    // depth of the root of the task in the enumeration tree
+  uint8_t root_size;
+  uint16_t root[max_root];   // first coordinates of the root of the task
+};
+
+class Tracer {
+
+  struct Buffer {
+    uint32_t tid;
+    int worker;
+    std::vector<TraceEvent> events;
+    uint64_t recorded;
+    Buffer *next;
+  };
+  std::atomic<bool> enabled {false};
+  std::atomic<size_t> capacity {0};
+  std::atomic<uint32_t> nthreads {0};
+  std::atomic<Buffer *> head {nullptr};
+  std::atomic<int64_t> epoch {0};
+
+  Buffer &register_thread() {
+#ifdef USE_CILK
+    const int worker = __cilkrts_get_worker_number();
+#else
+    const int worker = 0;
+#endif
+    Buffer *buf = new Buffer {nthreads.fetch_add(1), worker, {}, 0,
+			      head.load(std::memory_order_relaxed)};
+    while (not head.compare_exchange_weak(buf->next, buf, std::memory_order_release)) {}
+    return *buf;
+  }
+
+  static int64_t clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void write_event(std::ostream &out, const TraceEvent &ev, bool &first) const;
+
+public:
+
+  constexpr Tracer() {}
+
+  bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+  // Start tracing, keeping the last capacity events of each thread
+  void enable(size_t cap = 1 << 16) {
+    if (epoch.load() == 0) epoch.store(clock_ns());
+    capacity.store(cap);
+    enabled.store(true, std::memory_order_relaxed);
+  }
+  void disable() { enabled.store(false, std::memory_order_relaxed); }
+
+  uint64_t now() const { return clock_ns() - epoch.load(std::memory_order_relaxed); }
+
+  // Buffer of the calling thread
+  Buffer &local() {
+    static thread_local Buffer *buf = nullptr;
+    if (not buf) buf = &register_thread();
+    return *buf;
+  }
+
+  void record(const TraceEvent &ev) {
+    Buffer &buf = local();
+    const size_t cap = capacity.load(std::memory_order_relaxed);
+    if (cap == 0) return;
+    if (buf.events.size() < cap) buf.events.push_back(ev);
+    else buf.events[buf.recorded % buf.events.size()] = ev;
+    buf.recorded++;
+  }
+
+  // Not synchronized: to be called when no enumeration is running
+  void reset() {
+    for (Buffer *b = head.load(std::memory_order_acquire); b; b = b->next) {
+      b->events.clear();
+      b->recorded = 0;
+    }
+    epoch.store(clock_ns());
+  }
+  // Events overwritten in the ring buffers
+  uint64_t dropped() const {
+    uint64_t res = 0;
+    for (Buffer *b = head.load(std::memory_order_acquire); b; b = b->next)
+      res += b->recorded - b->events.size();
+    return res;
+  }
+  std::vector<TraceEvent> events() const {
+    std::vector<TraceEvent> res;
+    for (Buffer *b = head.load(std::memory_order_acquire); b; b = b->next)
+      res.insert(res.end(), b->events.begin(), b->events.end());
+    std::sort(res.begin(), res.end(), [](const TraceEvent &a, const TraceEvent &b) {
+	return a.tid != b.tid ? a.tid < b.tid : a.start < b.start; });
+    return res;
+  }
+  // Write the events as Chrome trace JSON. The gaps between the outermost
+  // spans of a thread are written as idle spans.
+  void write_json(std::ostream &out) const;
+  bool write_json(const std::string &filename) const {
+    std::ofstream out(filename);
+    write_json(out);
+    return bool(out);
+  }
+};
+
+inline void Tracer::write_event(std::ostream &out, const TraceEvent &ev, bool &first) const {
+  out << (first ? "\n" : ",\n") << "{\"name\":\"" << ev.name << "\",\"ph\":\"" << ev.phase
+      << "\",\"pid\":0,\"tid\":" << ev.tid << ",\"ts\":" << ev.start * 1e-3;
+  if (ev.phase == 'X') out << ",\"dur\":" << ev.duration * 1e-3;
+  if (ev.phase == 'i') out << ",\"s\":\"t\"";
+  if (ev.root_size) {
+    out << ",\"args\":{\"depth\":" << ev.depth << ",\"root\":\"[";
+    for (size_t i=0; i<ev.root_size; i++) out << (i ? "," : "") << ev.root[i];
+    out << "]\"}";
+  }
+  out << "}";
+  first = false;
+}
+
+inline void Tracer::write_json(std::ostream &out) const {
+  const std::vector<TraceEvent> evs = events();
+  bool first = true;
+  const auto flags = out.flags();
+  const auto precision = out.precision();
+  // Microseconds with nanosecond resolution
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (Buffer *b = head.load(std::memory_order_acquire); b; b = b->next) {
+    out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+	<< b->tid << ",\"args\":{\"name\":\"worker " << b->worker << "\"}}";
+    first = false;
+  }
+  uint64_t trace_start = evs.empty() ? 0 : evs[0].start;
+  for (const TraceEvent &ev : evs) trace_start = std::min(trace_start, ev.start);
+  for (size_t i = 0; i < evs.size(); ) {
+    const uint32_t tid = evs[i].tid;
+    uint64_t covered = trace_start;
+    for (; i < evs.size() and evs[i].tid == tid; i++) {
+      const TraceEvent &ev = evs[i];
+      if (ev.phase == 'X') {
+	if (ev.start > covered) {
+	  TraceEvent idle {"idle", 'X', tid, covered, ev.start - covered, 0, 0, {}};
+	  write_event(out, idle, first);
+	}
+	covered = std::max(covered, ev.start + ev.duration);
+      }
+      write_event(out, ev, first);
+    }
+  }
+  out << "\n]}\n";
+  out.flags(flags);
+  out.precision(precision);
+}
+
+// Allows for a single instance in a header only library
+template <class Dummy = void>
+struct TracerHolder { static Tracer tracer; };
+template <class Dummy>
+Tracer TracerHolder<Dummy>::tracer;
+
+inline Tracer &tracer() { return TracerHolder<>::tracer; }
+
+// Records the span of a task of the enumeration. Under Cilk, the
+// continuation of a spawn or a sync may run on another thread: resume then
+// closes the span on the previous thread and records the steal. Does nothing
+// if the tracing was disabled at construction.
+class TraceTask {
+  bool active;
+  TraceEvent ev;
+
+  void close(uint64_t end) {
+    ev.duration = end - ev.start;
+    tracer().record(ev);
+  }
+  void instant(const char *name, uint64_t time) {
+    TraceEvent res = ev;
+    res.name = name;
+    res.phase = 'i';
+    res.start = time;
+    res.duration = 0;
+    tracer().record(res);
+  }
+
+public:
+
+  template<class Vect>
+  TraceTask(const char *name, uint64_t depth, const Vect &root, uint64_t n) :
+    active(tracer().is_enabled()) {
+    if (not active) return;
+    ev.name = name;
+    ev.phase = 'X';
+    ev.tid = tracer().local().tid;
+    ev.depth = depth;
+    ev.root_size = std::min<uint64_t>(n, TraceEvent::max_root);
+    for (size_t i=0; i<ev.root_size; i++) ev.root[i] = root[i];
+    ev.start = tracer().now();
+  }
+  TraceTask(const TraceTask &) = delete;
+  ~TraceTask() { if (active) close(tracer().now()); }
+
+  // Time before a spawn or a sync, to be given to resume
+  uint64_t spawn() {
+    if (not active) return 0;
+    const uint64_t time = tracer().now();
+    instant("spawn", time);
+    return time;
+  }
+  uint64_t sync() const { return active ? tracer().now() : 0; }
+  void resume(uint64_t time) {
+    if (not active) return;
+    const uint32_t tid = tracer().local().tid;
+    if (tid == ev.tid) return;
+    close(time);
+    ev.tid = tid;
+    ev.start = tracer().now();
+    instant("steal", ev.start);
+  }
+};
+
+} // namespace IVMPG
+
+#endif // _TRACER_HPP